@@ -0,0 +1,769 @@
+/*	##############################################################################################
+	Advanced RTI System, ARTÌS			http://pads.cs.unibo.it
+	Large Unstructured NEtwork Simulator (LUNES)
+
+	Description:
+		For a general introduction to LUNES implmentation please see the
+		file: mig-agents.c
+
+		This an external tool used to prepare the graph corpuses.
+
+		The goal of this tool is to convert a graph definition in dot format
+		(as generated by graphgen) in the binary CSR format that is directly
+		mapped in memory by the simulator (see graph_format.h).
+
+		Optionally, the vertices are partitioned among the LPs: the SEs are
+		assigned to the LPs by ID (NSIMULATE consecutive IDs in each LP) and
+		therefore the vertices are relabeled to place in the same LP the
+		vertices of the same partition. The partitions have the same size and
+		are built to minimize the number of edges between different LPs.
+
+		Optionally, the vertices are also reordered to improve the memory
+		locality of the simulator (inside each partition, if partitioned):
+		the neighbors of each vertex get close IDs and therefore their
+		data structures are close in memory.
+
+	Authors:
+		First version by Gabriele D'Angelo <g.dangelo@unibo.it>
+
+	###############################################################################################
+*/
+
+/*
+	Input arguments and their semantic:
+
+		argv[1]		Filename of the graph in dot format (input)
+		argv[2]		Filename of the graph in binary format (output)
+		argv[3]		Number of vertices (optional, 0 or missing means the max vertex ID + 1)
+		argv[4]		Number of LPs for the partitioning (optional, 0 or missing means no partitioning)
+		argv[5]		Ordering of the vertices (optional, default is none):
+				none	the original order is kept
+				bfs	breadth-first visit order
+				rcm	reverse Cuthill-McKee order
+				degree	decreasing degree order
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "graph_format.h"
+
+/*	Max number of refinement passes of the partitioning */
+#define PARTITION_PASSES	16
+
+/*	Vertex not assigned to any partition */
+#define PART_NONE		UINT32_MAX
+
+/*	Orderings of the vertices */
+#define ORDER_NONE		0
+#define ORDER_BFS		1
+#define ORDER_RCM		2
+#define ORDER_DEGREE		3
+
+/*	Edges read from the dot file */
+typedef struct edge {
+	uint32_t	source;
+	uint32_t	destination;
+} Edge;
+
+/*	Graph in CSR format */
+typedef struct graph {
+	uint32_t	vertices;
+	uint32_t	max_degree;
+	uint64_t	entries;
+	uint64_t	*offsets;
+	uint32_t	*neighbors;
+} Graph;
+
+/*	Graph used by the comparisons of vertices by degree (qsort has no context argument) */
+static const Graph	*degree_graph;
+
+/*	Candidate move of the partitioning refinement */
+typedef struct move {
+	uint32_t	vertex;
+	uint32_t	from;
+	uint32_t	to;
+	int32_t		gain;
+} Move;
+
+
+/*
+	Comparison of edges, used to find the duplicates
+*/
+static int	edge_compare (const void *a, const void *b) {
+
+	const Edge	*x = (const Edge *)a;
+	const Edge	*y = (const Edge *)b;
+
+
+	if ( x->source != y->source )	return ( ( x->source > y->source ) - ( x->source < y->source ) );
+	return ( ( x->destination > y->destination ) - ( x->destination < y->destination ) );
+}
+
+
+/*
+	Comparison of vertex IDs, used to sort the neighbors after relabeling
+*/
+static int	vertex_compare (const void *a, const void *b) {
+
+	uint32_t	x = *(const uint32_t *)a;
+	uint32_t	y = *(const uint32_t *)b;
+
+
+	return ( ( x > y ) - ( x < y ) );
+}
+
+
+/*
+	Comparison of vertices by increasing degree (and ID)
+*/
+static int	degree_compare (const void *a, const void *b) {
+
+	uint32_t	x = *(const uint32_t *)a;
+	uint32_t	y = *(const uint32_t *)b;
+	uint64_t	dx = degree_graph->offsets[x + 1] - degree_graph->offsets[x];
+	uint64_t	dy = degree_graph->offsets[y + 1] - degree_graph->offsets[y];
+
+
+	if ( dx != dy )	return ( ( dx > dy ) - ( dx < dy ) );
+	return ( ( x > y ) - ( x < y ) );
+}
+
+
+/*
+	Comparison of vertices by decreasing degree (and increasing ID)
+*/
+static int	degree_compare_decreasing (const void *a, const void *b) {
+
+	uint32_t	x = *(const uint32_t *)a;
+	uint32_t	y = *(const uint32_t *)b;
+	uint64_t	dx = degree_graph->offsets[x + 1] - degree_graph->offsets[x];
+	uint64_t	dy = degree_graph->offsets[y + 1] - degree_graph->offsets[y];
+
+
+	if ( dx != dy )	return ( ( dx < dy ) - ( dx > dy ) );
+	return ( ( x > y ) - ( x < y ) );
+}
+
+
+/*
+	Comparison of moves: grouped by (from, to) and then by decreasing gain
+*/
+static int	move_compare (const void *a, const void *b) {
+
+	const Move	*x = (const Move *)a;
+	const Move	*y = (const Move *)b;
+
+
+	if ( x->from != y->from )	return ( ( x->from > y->from ) - ( x->from < y->from ) );
+	if ( x->to != y->to )		return ( ( x->to > y->to ) - ( x->to < y->to ) );
+	return ( ( x->gain < y->gain ) - ( x->gain > y->gain ) );
+}
+
+
+/*
+	Memory allocation, the conversion is aborted if there is not enough memory
+*/
+static void *	xmalloc (uint64_t size) {
+
+	void	*p = malloc(size ? size : 1);
+
+
+	if ( p == NULL ) {
+
+		fprintf(stderr, "FATAL ERROR, not enough memory\n");
+		exit(1);
+	}
+	return(p);
+}
+
+
+/*
+	Reads all the edges in the dot file, both the directions of each edge are
+	returned (the lines that do not define an edge are skipped)
+*/
+static Edge *	read_edges (const char *filename, uint64_t *count, uint32_t *vertices, unsigned long *loops) {
+
+	FILE		*f_dot;
+	char		buffer[1024];
+	int		source, destination;
+	Edge		*edges = NULL;
+	uint64_t	allocated = 0;
+
+
+	if ( ( f_dot = fopen(filename, "r") ) == NULL ) {
+
+		fprintf(stderr, "FATAL ERROR, impossible to open the input file: %s\n", filename);
+		exit(1);
+	}
+
+	*count = 0;
+	*vertices = 0;
+	*loops = 0;
+
+	while ( fgets(buffer, 1024, f_dot) != NULL ) {
+
+		if ( sscanf(buffer, "%d -- %d", &source, &destination) != 2 )
+			continue;
+
+		if ( ( source < 0 ) || ( destination < 0 ) ) {
+
+			fprintf(stderr, "FATAL ERROR, negative vertex ID in the edge: %d -- %d\n", source, destination);
+			exit(1);
+		}
+
+		// Self loops are not supported by the simulator
+		if ( source == destination ) {
+
+			(*loops)++;
+			continue;
+		}
+
+		if ( *count == allocated ) {
+
+			allocated = allocated ? ( allocated * 2 ) : 4096;
+			edges = realloc(edges, allocated * 2 * sizeof(Edge));
+			if ( edges == NULL ) {
+
+				fprintf(stderr, "FATAL ERROR, not enough memory for the edges\n");
+				exit(1);
+			}
+		}
+
+		// The graph is undirected, both the directions are stored
+		edges[2 * *count].source		= source;
+		edges[2 * *count].destination		= destination;
+		edges[2 * *count + 1].source		= destination;
+		edges[2 * *count + 1].destination	= source;
+		(*count)++;
+
+		if ( (uint32_t)source >= *vertices )		*vertices = source + 1;
+		if ( (uint32_t)destination >= *vertices )	*vertices = destination + 1;
+	}
+
+	fclose(f_dot);
+
+	// Number of directed entries
+	*count *= 2;
+
+	return(edges);
+}
+
+
+/*
+	Builds the CSR graph from the edges, the duplicates are removed
+	and the neighbors of each vertex are sorted
+*/
+static void	graph_build (Graph *graph, Edge *edges, uint64_t count, uint32_t vertices, unsigned long *duplicates) {
+
+	uint64_t	unique = 0, i;
+	uint32_t	v, degree;
+
+
+	// Sorting the edges, the neighbors of each vertex become ordered and the duplicates adjacent
+	qsort(edges, count, sizeof(Edge), edge_compare);
+
+	*duplicates = 0;
+	for ( i = 0; i < count; i++ ) {
+
+		if ( ( unique > 0 ) && ( edge_compare(&edges[unique - 1], &edges[i]) == 0 ) ) {
+
+			(*duplicates)++;
+			continue;
+		}
+		edges[unique++] = edges[i];
+	}
+
+	graph->vertices		= vertices;
+	graph->entries		= unique;
+	graph->offsets		= calloc((uint64_t)vertices + 1, sizeof(uint64_t));
+	graph->neighbors	= xmalloc(unique * sizeof(uint32_t));
+	if ( graph->offsets == NULL ) {
+
+		fprintf(stderr, "FATAL ERROR, not enough memory for the CSR arrays\n");
+		exit(1);
+	}
+
+	for ( i = 0; i < unique; i++ ) {
+
+		graph->offsets[edges[i].source + 1]++;
+		graph->neighbors[i] = edges[i].destination;
+	}
+
+	graph->max_degree = 0;
+	for ( v = 0; v < vertices; v++ ) {
+
+		// Before the prefix sum, offsets[v + 1] is the degree of the vertex v
+		degree = graph->offsets[v + 1];
+		if ( degree > graph->max_degree )	graph->max_degree = degree;
+		graph->offsets[v + 1] += graph->offsets[v];
+	}
+}
+
+
+/*
+	Number of edges with the endpoints in different partitions
+*/
+static uint64_t	partition_cut (const Graph *graph, const uint32_t *part) {
+
+	uint64_t	cut = 0, i;
+	uint32_t	v;
+
+
+	for ( v = 0; v < graph->vertices; v++ )
+		for ( i = graph->offsets[v]; i < graph->offsets[v + 1]; i++ )
+			if ( ( graph->neighbors[i] > v ) && ( part[graph->neighbors[i]] != part[v] ) )
+				cut++;
+
+	return(cut);
+}
+
+
+/*
+	Initial partitioning: each partition is grown with a breadth-first visit
+	until it reaches its size, connected vertices tend to be in the same partition
+*/
+static void	partition_grow (const Graph *graph, uint32_t parts, uint32_t *part) {
+
+	uint32_t	size = graph->vertices / parts;
+	uint32_t	*queue, *stamp;
+	uint32_t	head, tail, filled, next = 0, p, v, u;
+	uint64_t	i;
+
+
+	queue = xmalloc((uint64_t)graph->vertices * sizeof(uint32_t));
+	stamp = calloc(graph->vertices, sizeof(uint32_t));
+	if ( stamp == NULL ) {
+
+		fprintf(stderr, "FATAL ERROR, not enough memory\n");
+		exit(1);
+	}
+
+	for ( v = 0; v < graph->vertices; v++ )	part[v] = PART_NONE;
+
+	for ( p = 0; p < parts; p++ ) {
+
+		head = tail = filled = 0;
+
+		while ( filled < size ) {
+
+			// A new seed is needed (first vertex of the partition or disconnected graph)
+			if ( head == tail ) {
+
+				while ( part[next] != PART_NONE )	next++;
+				queue[tail++] = next;
+				stamp[next] = p + 1;
+			}
+
+			v = queue[head++];
+			part[v] = p;
+			filled++;
+
+			for ( i = graph->offsets[v]; i < graph->offsets[v + 1]; i++ ) {
+
+				u = graph->neighbors[i];
+				if ( ( part[u] == PART_NONE ) && ( stamp[u] != p + 1 ) ) {
+
+					stamp[u] = p + 1;
+					queue[tail++] = u;
+				}
+			}
+		}
+	}
+
+	free(queue);
+	free(stamp);
+}
+
+
+/*
+	Refinement of the partitioning: the vertices that have more neighbors in
+	another partition are swapped in pairs, to keep the partitions balanced.
+	The best partitioning that has been found is kept
+*/
+static uint64_t	partition_refine (const Graph *graph, uint32_t parts, uint32_t *part) {
+
+	uint32_t	*best, *links, *touched, *starts;
+	Move		*moves;
+	uint32_t	count, ntouched, pass, v, u, a, b, t, j, k, n_ab, n_ba;
+	uint64_t	i, cut, best_cut;
+	int32_t		gain;
+
+
+	best	= xmalloc((uint64_t)graph->vertices * sizeof(uint32_t));
+	links	= calloc(parts, sizeof(uint32_t));
+	touched	= xmalloc((uint64_t)parts * sizeof(uint32_t));
+	starts	= xmalloc(((uint64_t)parts * parts + 1) * sizeof(uint32_t));
+	moves	= xmalloc((uint64_t)graph->vertices * sizeof(Move));
+	if ( links == NULL ) {
+
+		fprintf(stderr, "FATAL ERROR, not enough memory\n");
+		exit(1);
+	}
+
+	memcpy(best, part, graph->vertices * sizeof(uint32_t));
+	best_cut = partition_cut(graph, part);
+
+	for ( pass = 0; pass < PARTITION_PASSES; pass++ ) {
+
+		// Each vertex is a candidate to move in the partition with most of its neighbors
+		count = 0;
+		for ( v = 0; v < graph->vertices; v++ ) {
+
+			ntouched = 0;
+			for ( i = graph->offsets[v]; i < graph->offsets[v + 1]; i++ ) {
+
+				u = part[graph->neighbors[i]];
+				if ( links[u]++ == 0 )	touched[ntouched++] = u;
+			}
+
+			t = part[v];
+			for ( j = 0; j < ntouched; j++ )
+				if ( links[touched[j]] > links[t] )	t = touched[j];
+
+			gain = (int32_t)links[t] - (int32_t)links[part[v]];
+			if ( gain > 0 ) {
+
+				moves[count].vertex	= v;
+				moves[count].from	= part[v];
+				moves[count].to		= t;
+				moves[count].gain	= gain;
+				count++;
+			}
+
+			for ( j = 0; j < ntouched; j++ )	links[touched[j]] = 0;
+		}
+
+		if ( count == 0 )	break;
+
+		qsort(moves, count, sizeof(Move), move_compare);
+
+		// Position of the moves of each (from, to) pair
+		for ( k = 0, j = 0; k <= parts * parts; k++ ) {
+
+			while ( ( j < count ) && ( moves[j].from * parts + moves[j].to < k ) )	j++;
+			starts[k] = j;
+		}
+
+		// Swaps between each pair of partitions, the best candidates first
+		for ( a = 0; a < parts; a++ ) {
+
+			for ( b = a + 1; b < parts; b++ ) {
+
+				n_ab = starts[a * parts + b + 1] - starts[a * parts + b];
+				n_ba = starts[b * parts + a + 1] - starts[b * parts + a];
+
+				for ( j = 0; ( j < n_ab ) && ( j < n_ba ); j++ ) {
+
+					part[moves[starts[a * parts + b] + j].vertex] = b;
+					part[moves[starts[b * parts + a] + j].vertex] = a;
+				}
+			}
+		}
+
+		// The gains are estimated, only the real improvements are kept
+		cut = partition_cut(graph, part);
+		if ( cut >= best_cut ) {
+
+			memcpy(part, best, graph->vertices * sizeof(uint32_t));
+			break;
+		}
+
+		best_cut = cut;
+		memcpy(best, part, graph->vertices * sizeof(uint32_t));
+	}
+
+	free(best);
+	free(links);
+	free(touched);
+	free(starts);
+	free(moves);
+
+	return(best_cut);
+}
+
+
+/*
+	Reorders a block of vertices (a partition or the whole graph), only the
+	edges inside the block are followed by the visits.
+	The vertices of the block have to be marked in "stamp" with "mark", the
+	visited ones are unmarked. "seeds" and "visit" have the size of the block
+*/
+static void	order_block (const Graph *graph, uint32_t *block, uint32_t size, int method, uint32_t *stamp, uint32_t mark, uint32_t *seeds, uint32_t *visit) {
+
+	uint32_t	head = 0, tail = 0, first, s, v, u, i;
+	uint64_t	j;
+
+
+	degree_graph = graph;
+
+	if ( method == ORDER_DEGREE ) {
+
+		qsort(block, size, sizeof(uint32_t), degree_compare_decreasing);
+		return;
+	}
+
+	// The visits start from the vertices with the lowest degree, that are
+	//	likely to be peripheral (i.e. the levels of the visit are narrow)
+	memcpy(seeds, block, size * sizeof(uint32_t));
+	qsort(seeds, size, sizeof(uint32_t), degree_compare);
+
+	for ( s = 0; s < size; s++ ) {
+
+		// A new connected component of the block
+		if ( stamp[seeds[s]] != mark )	continue;
+
+		stamp[seeds[s]] = 0;
+		visit[tail++] = seeds[s];
+
+		while ( head < tail ) {
+
+			v = visit[head++];
+			first = tail;
+
+			for ( j = graph->offsets[v]; j < graph->offsets[v + 1]; j++ ) {
+
+				u = graph->neighbors[j];
+				if ( stamp[u] == mark ) {
+
+					stamp[u] = 0;
+					visit[tail++] = u;
+				}
+			}
+
+			// Cuthill-McKee: the neighbors are visited by increasing degree
+			if ( method == ORDER_RCM )
+				qsort(&visit[first], tail - first, sizeof(uint32_t), degree_compare);
+		}
+	}
+
+	// Reverse Cuthill-McKee
+	if ( method == ORDER_RCM ) {
+
+		for ( i = 0; i < size / 2; i++ ) {
+
+			v = visit[i];
+			visit[i] = visit[size - 1 - i];
+			visit[size - 1 - i] = v;
+		}
+	}
+
+	memcpy(block, visit, size * sizeof(uint32_t));
+}
+
+
+/*
+	Mean distance between the IDs of neighbors, a measure of the memory locality
+*/
+static double	neighbor_distance (const Graph *graph) {
+
+	double		total = 0;
+	uint32_t	v;
+	uint64_t	j;
+
+
+	for ( v = 0; v < graph->vertices; v++ )
+		for ( j = graph->offsets[v]; j < graph->offsets[v + 1]; j++ )
+			total += ( graph->neighbors[j] > v ) ? ( graph->neighbors[j] - v ) : ( v - graph->neighbors[j] );
+
+	return ( graph->entries ? ( total / graph->entries ) : 0 );
+}
+
+
+/*
+	Relabels the vertices of the graph: order[i] is the (old) vertex that will have ID i
+*/
+static void	graph_relabel (Graph *graph, const uint32_t *order) {
+
+	uint64_t	*offsets;
+	uint32_t	*neighbors, *label;
+	uint32_t	i, v;
+	uint64_t	j, position;
+
+
+	label		= xmalloc((uint64_t)graph->vertices * sizeof(uint32_t));
+	offsets		= xmalloc(((uint64_t)graph->vertices + 1) * sizeof(uint64_t));
+	neighbors	= xmalloc(graph->entries * sizeof(uint32_t));
+
+	for ( i = 0; i < graph->vertices; i++ )	label[order[i]] = i;
+
+	offsets[0] = 0;
+	for ( i = 0; i < graph->vertices; i++ ) {
+
+		v = order[i];
+		position = offsets[i];
+
+		for ( j = graph->offsets[v]; j < graph->offsets[v + 1]; j++ )
+			neighbors[position++] = label[graph->neighbors[j]];
+
+		offsets[i + 1] = position;
+		qsort(&neighbors[offsets[i]], position - offsets[i], sizeof(uint32_t), vertex_compare);
+	}
+
+	free(graph->offsets);
+	free(graph->neighbors);
+	free(label);
+
+	graph->offsets = offsets;
+	graph->neighbors = neighbors;
+}
+
+
+int	main (int argc, char *argv[]) {
+
+	FILE			*f_csr;
+	Edge			*edges;
+	Graph			graph;
+	uint64_t		count, cut = 0;
+	uint32_t		vertices, parts = 0, blocks, size, v, p;
+	uint32_t		*part = NULL, *order = NULL, *position, *stamp, *seeds, *visit;
+	struct graph_header	header;
+	unsigned long		loops, duplicates;
+	int			method = ORDER_NONE;
+	double			distance;
+
+
+	if ( ( argc < 3 ) || ( argc > 6 ) ) {
+
+		fprintf(stderr, "USAGE: %s <graph.dot> <graph.csr> [#vertices] [#LPs] [none|bfs|rcm|degree]\n", argv[0]);
+		exit(1);
+	}
+
+	if ( argc == 6 ) {
+
+		if ( strcmp(argv[5], "none") == 0 )		method = ORDER_NONE;
+		else if ( strcmp(argv[5], "bfs") == 0 )		method = ORDER_BFS;
+		else if ( strcmp(argv[5], "rcm") == 0 )		method = ORDER_RCM;
+		else if ( strcmp(argv[5], "degree") == 0 )	method = ORDER_DEGREE;
+		else {
+
+			fprintf(stderr, "FATAL ERROR, unknown ordering of the vertices: %s\n", argv[5]);
+			exit(1);
+		}
+	}
+
+	edges = read_edges(argv[1], &count, &vertices, &loops);
+
+	if ( ( argc >= 4 ) && ( atoi(argv[3]) > 0 ) ) {
+
+		if ( (uint32_t)atoi(argv[3]) < vertices ) {
+
+			fprintf(stderr, "FATAL ERROR, the graph contains vertices with ID greater or equal than %s\n", argv[3]);
+			exit(1);
+		}
+		vertices = atoi(argv[3]);
+	}
+
+	if ( ( argc >= 5 ) && ( atoi(argv[4]) > 1 ) ) {
+
+		parts = atoi(argv[4]);
+		if ( vertices % parts ) {
+
+			fprintf(stderr, "FATAL ERROR, the %u vertices can not be evenly partitioned among %u LPs\n", vertices, parts);
+			exit(1);
+		}
+	}
+
+	graph_build(&graph, edges, count, vertices, &duplicates);
+	free(edges);
+
+	// Partitioning: the vertices of the LP p will have the IDs [p * size, (p + 1) * size)
+	if ( parts ) {
+
+		part = xmalloc((uint64_t)vertices * sizeof(uint32_t));
+		partition_grow(&graph, parts, part);
+		cut = partition_refine(&graph, parts, part);
+
+		// The original order is kept inside each partition
+		order = xmalloc((uint64_t)vertices * sizeof(uint32_t));
+		position = calloc(parts, sizeof(uint32_t));
+		if ( position == NULL ) {
+
+			fprintf(stderr, "FATAL ERROR, not enough memory\n");
+			exit(1);
+		}
+
+		for ( v = 0; v < vertices; v++ ) {
+
+			p = part[v];
+			order[p * (vertices / parts) + position[p]++] = v;
+		}
+
+		free(position);
+	}
+
+	// Reordering: the vertices are reordered inside each partition (or in the whole graph)
+	if ( method != ORDER_NONE ) {
+
+		blocks = parts ? parts : 1;
+		size = vertices / blocks;
+
+		if ( order == NULL ) {
+
+			order = xmalloc((uint64_t)vertices * sizeof(uint32_t));
+			for ( v = 0; v < vertices; v++ )	order[v] = v;
+		}
+
+		stamp = calloc(vertices, sizeof(uint32_t));
+		seeds = xmalloc((uint64_t)size * sizeof(uint32_t));
+		visit = xmalloc((uint64_t)size * sizeof(uint32_t));
+		if ( stamp == NULL ) {
+
+			fprintf(stderr, "FATAL ERROR, not enough memory\n");
+			exit(1);
+		}
+
+		for ( p = 0; p < blocks; p++ ) {
+
+			for ( v = 0; v < size; v++ )	stamp[order[p * size + v]] = p + 1;
+			order_block(&graph, &order[p * size], size, method, stamp, p + 1, seeds, visit);
+		}
+
+		free(stamp);
+		free(seeds);
+		free(visit);
+	}
+
+	distance = neighbor_distance(&graph);
+
+	if ( order )
+		graph_relabel(&graph, order);
+
+	header.magic		= GRAPH_MAGIC;
+	header.version		= GRAPH_VERSION;
+	header.vertices		= graph.vertices;
+	header.max_degree	= graph.max_degree;
+	header.entries		= graph.entries;
+	header.parts		= parts;
+	header.relabeled	= ( order != NULL );
+
+	if ( ( f_csr = fopen(argv[2], "wb") ) == NULL ) {
+
+		fprintf(stderr, "FATAL ERROR, impossible to open the output file: %s\n", argv[2]);
+		exit(1);
+	}
+
+	if ( 	( fwrite(&header, sizeof(header), 1, f_csr) != 1 ) ||
+		( fwrite(graph.offsets, sizeof(uint64_t), (uint64_t)vertices + 1, f_csr) != (uint64_t)vertices + 1 ) ||
+		( fwrite(graph.neighbors, sizeof(uint32_t), graph.entries, f_csr) != graph.entries ) ||
+		( order && ( fwrite(order, sizeof(uint32_t), vertices, f_csr) != vertices ) ) ||
+		( fclose(f_csr) != 0 )
+	) {
+		fprintf(stderr, "FATAL ERROR, impossible to write the output file: %s\n", argv[2]);
+		exit(1);
+	}
+
+	fprintf(stdout, "%s: %u vertices, %lu edges, max degree %u", argv[2], vertices, (unsigned long)(graph.entries / 2), graph.max_degree);
+	if ( loops )		fprintf(stdout, ", %lu self loops skipped", loops);
+	if ( duplicates )	fprintf(stdout, ", %lu duplicate edges skipped", duplicates / 2);
+	if ( parts )		fprintf(stdout, ", %u LPs with %lu edges between different LPs (%.2f%%)", parts, (unsigned long)cut, graph.entries ? ( 200.0 * cut / graph.entries ) : 0.0);
+	if ( order )		fprintf(stdout, ", mean ID distance of neighbors %.1f (was %.1f)", neighbor_distance(&graph), distance);
+	fprintf(stdout, "\n");
+
+	free(graph.offsets);
+	free(graph.neighbors);
+	free(part);
+	free(order);
+
+	return(0);
+}
@@ -21,10 +21,6 @@
 //	in LUNES used to implement neighbors and its properties
 typedef struct v_e {
 	unsigned int	value;						// Value
-	#ifdef ADAPTIVE_GOSSIP_SUPPORT
-	double		stim_timeout[ADAPTIVE_GOSSIP_MAX_NODES];	// Table of stimuli timeouts
-	float		stim_increment[ADAPTIVE_GOSSIP_MAX_NODES];	// Table of stimuli increments
-	#endif
 
 	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 	unsigned int 	num_neighbors; 					// Number of neighbors of each neighbor of a given node
@@ -40,28 +36,101 @@ struct state_element {
 
 // Structure of the cache element
 typedef struct cache_element {
-	long		element;				// Cached element ID
-	float		age;					// Time of insertion
+	unsigned int	element;				// Cached element ID
+	unsigned short	newer;					// Recency list: next more recently used slot
+	unsigned short	older;					// Recency list: next less recently used slot
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	float		timestamp;				// Timestep of creation of the cached message
+	unsigned int	creator;				// ID of the original sender of the cached message
+	#endif
 } CacheElement;
 
+// Cache used to suppress duplicate messages, the lookup is done using an open addressing
+//	index (linear probing) and the eviction of the oldest element using a recency list,
+//	both are O(1). The ties in the same timestep are broken by the order of the events. The slots are linked by position and not by pointer, so the whole
+//	cache can be copied in a migration message
+typedef struct cache {
+	unsigned short	used;					// Number of slots in use
+	unsigned short	newest;					// Most recently used (inserted or hit) slot
+	unsigned short	oldest;					// Least recently used slot, the next to be evicted
+	unsigned short	index[CACHE_INDEX_SIZE];		// Index buckets: slot position + 1, 0 if empty
+	CacheElement	slots[MAX_CACHE_SIZE];			// Cached elements
+} Cache;
+
+#ifdef ADAPTIVE_GOSSIP_SUPPORT
+// History of received events, used for adaptive gossip algorithms: number of messages
+//	produced by a given sender that have been received from a given forwarder
+typedef struct history_forwarder {
+	unsigned int		forwarder;			// Forwarder ID
+	unsigned char		count;				// Received messages (saturated to 254)
+} HistoryForwarder;
+
+// History of received events of a given sender, only the senders and the forwarders
+//	that have been seen in the current evaluation period are allocated
+typedef struct history_sender {
+	unsigned int		sender;				// Sender ID (also used as key in the history table)
+	unsigned int		total;				// Total number of received messages (from all forwarders)
+	int			best_forwarder;			// Forwarder with the max count (the lowest ID wins ties)
+	unsigned char		best_count;			// Count of the best forwarder
+	unsigned int		used;				// Number of forwarders in use
+	unsigned int		size;				// Number of allocated forwarders
+	HistoryForwarder	*forwarders;			// Forwarders of the messages produced by the sender
+} HistorySender;
+#endif
+
+#ifdef ADAPTIVE_GOSSIP_SUPPORT
+// Active stimulus, it increments the dissemination probability of the messages produced
+//	by a given sender (cursor) towards a given neighbor. In alg. #1 the cursor is always 0,
+//	in alg. #2 the stimuli are associated to the node and the neighbor is always 0
+typedef struct stimulus_element {
+	unsigned int		neighbor;			// Neighbor ID
+	unsigned int		cursor;				// Sender ID
+	double			timeout;			// Timestep in which the stimulus expires
+	float			increment;			// Increment of the dissemination probability
+} StimulusElement;
+#endif
+
 // Static part of the SE state
 typedef struct static_data_t {
-	char			changed;			// ON if there has been a state change in the last timestep
 	float			time_of_next_message;		// Timestep in which the next new message will be created and sent
-	CacheElement		cache[MAX_CACHE_SIZE];		// Cache local to each node, used to suppress duplicate messages
+	Cache			cache;				// Cache local to each node, used to suppress duplicate messages
+	unsigned int		duplicates;			// Statistics: received messages that were already cached
+	unsigned int		ttl_drops;			// Statistics: received messages with expired TTL that were not cached
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	float			time_of_next_pull;		// Timestep in which the next digest will be sent (pull phase)
+	#endif
 	#ifdef ADAPTIVE_GOSSIP_SUPPORT
-	unsigned char		histable[ADAPTIVE_GOSSIP_MAX_NODES][ADAPTIVE_GOSSIP_MAX_NODES];		
-								// Main table of received events, used for adaptive gossip algorithms
-	unsigned int		histable_cleanup;		// Last timestep in which the histable has been cleaned up
+	unsigned int		histable_cleanup;		// Last timestep in which the history has been cleaned up
 	#endif
 } static_data_t;
 
-// SE state definition
-typedef struct hash_data_t {
+// Record of the directory of SEs, it is kept for every SE in the simulation (both local
+//	and remote) and therefore it contains only what is needed to reach the SE
+typedef struct dir_data_t {
 	int			key;				// SE identifier
 	int 			lp;				// Logical Process ID (that is the SE container)
+	char			changed;			// ON if there has been a migration in the last timestep
+} dir_data_t;
+
+// SE state definition, it is allocated only for the SEs managed by the local LP
+typedef struct hash_data_t {
+	int			key;				// SE identifier
 	static_data_t		s_state;			// Static part of the SE local state
-	GHashTable*		state;				// Local state as an hash table (glib) (dynamic part)
+	GHashTable*		state;				// Local state as an hash table (glib) (dynamic part),
+								//	used only while the network topology is built
+	unsigned int		degree;				// Compact neighbors table (CSR): number of neighbors
+	unsigned int*		neighbors;			// Compact neighbors table (CSR): IDs, sorted
+	value_element*		neighbors_data;			// Compact neighbors table (CSR): extra data of each neighbor
+	struct dir_data_t**	neighbors_dir;			// Compact neighbors table (CSR): directory record of each neighbor,
+								//	it is local to the LP and resolved again after each migration
+	char			neighbors_owned;		// YES if the compact table is not a slice of the LP-wide one
+
+	#ifdef ADAPTIVE_GOSSIP_SUPPORT
+	GHashTable*		history;			// History of received events (HistorySender by sender ID),
+								//	it is not migrated: a new evaluation period starts
+	GHashTable*		stimuli;			// Active stimuli (StimulusElement by neighbor and cursor),
+								//	the expired ones are removed when found
+	#endif
 
 	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 	unsigned int 		num_neighbors;			// Number of SE's neighbors (dynamically updated)
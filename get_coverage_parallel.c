@@ -0,0 +1,784 @@
+/*	##############################################################################################
+	Advanced RTI System, ARTÌS			http://pads.cs.unibo.it
+	Large Unstructured NEtwork Simulator (LUNES)
+
+	Description:
+		For a general introduction to LUNES implmentation please see the
+		file: mig-agents.c
+
+		This an external tool used by the performance evaluation scripts.
+
+		The goal of this tool is to analyze the trace files produced by the
+		simulator in a single pass: it collects the message IDs and the node
+		IDs that are in the traces and it finds the coverage and the delay of
+		each delivered message with respect to each node in the simulated graph.
+
+		The trace files of the LPs (text or binary, see trace_format.h) are
+		processed in parallel by a pool of worker threads, the table of the
+		delays is shared and it is enlarged as new messages and nodes are
+		found in the traces.
+
+		In streaming mode the trace files are processed one timestep at a
+		time (the traces are in simulated time order) and each message is
+		finalized (i.e. its coverage and delay are accounted and its row of
+		the table is released) when its analysis window has passed: the
+		memory is proportional to the number of messages generated in the
+		window. The results are exact if the window is not shorter than the
+		maximum delay of the messages (e.g. the TTL in the push-based
+		dissemination modes), otherwise the analysis is aborted. The traces
+		without timestep records (older versions of the simulator) cannot
+		be processed in streaming mode, the whole table is used.
+
+		Two kernels are available for the table: the delays kernel keeps the
+		smallest delay of each (message, node) pair in a byte, the bitset
+		kernel keeps only a bit for each pair (8 times smaller) and the delay
+		is accounted when the pair is reached for the first time, the
+		coverage is found using the popcount of the rows. The bitset kernel
+		requires the traces to be processed in time order (as in streaming mode),
+		the delays kernel is used for the traces without timestep records.
+
+	Authors:
+		First version by Gabriele D'Angelo <g.dangelo@unibo.it>
+
+	###############################################################################################
+*/
+
+/*
+	Input arguments and their semantic:
+
+		argv[1]		Directory of the log (trace) files (input)
+		argv[2]		Total number of LPs in this run (input)
+		argv[3]		Filename of the message IDs file (output)
+		argv[4]		Filename of the nodes IDs file (output)
+		argv[5]		File name of the coverage file (output, the value is appended)
+		argv[6]		File name of the delay file (output, the value is appended)
+		argv[7]		Number of worker threads (optional, 0 or missing means one
+				for each LP, bounded by the number of available CPUs)
+		argv[8]		Analysis window in timesteps (optional, 0 or missing means
+				that the whole table is kept in memory, otherwise streaming
+				mode: the window is the maximum delay of the messages, the
+				largest supported delay is NOT_REACHED - 1)
+		argv[9]		Kernel of the table (optional, default is delays):
+				delays	smallest delay of each (message, node) pair
+				bitset	reached bit of each (message, node) pair
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "lunes_constants.h"
+#include "trace_format.h"
+
+/*	Records that are collected by a worker before updating the shared table */
+#define BATCH_RECORDS		4096
+
+/*	Delay of the (message, node) pairs that have not been reached */
+#define NOT_REACHED		UCHAR_MAX
+
+/*	Kernels of the table */
+#define KERNEL_DELAYS		0
+#define KERNEL_BITSET		1
+
+/*	Row of a message that has been finalized (streaming mode) */
+unsigned char		finalized_row;
+#define FINALIZED		(&finalized_row)
+
+/*	Delays table: a row for each message, a column for each node.
+	The message IDs are dense in each LP (see MESSAGE_ID) and therefore
+	the rows are indexed by LP and sequence number, the rows are allocated
+	when the message is found for the first time */
+unsigned char**		rows[1 << MESSAGE_ID_LP_BITS];		/* Rows of the messages generated in each LP */
+unsigned char*		generated[1 << MESSAGE_ID_LP_BITS];	/* The message has been found in a "G" record */
+unsigned int*		birth[1 << MESSAGE_ID_LP_BITS];		/* Timestep of the "G" record */
+unsigned int		rows_size[1 << MESSAGE_ID_LP_BITS];	/* Size of the rows, generated and birth arrays */
+unsigned int		columns = 0;				/* Nodes in each row (multiple of 64) */
+unsigned char*		nodes_seen = NULL;			/* The node has been found in the traces */
+
+/*	The workers update the table in shared mode, it is enlarged in exclusive mode */
+pthread_rwlock_t	table_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/*	Streaming mode: messages that have not been finalized yet */
+unsigned int*		live = NULL;
+unsigned int		live_count = 0;
+unsigned int		live_size = 0;
+unsigned int		live_max = 0;
+pthread_mutex_t		live_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*	Streaming mode: all the records up to this timestep are being processed */
+unsigned int		current_step = 0;
+int			streaming_done = 0;
+pthread_barrier_t	step_barrier;
+
+/*	Trace file of each LP, with the timestep record that stopped its processing */
+typedef struct trace_source {
+	char			name[1024];
+	TraceReader		reader;				/* Binary trace */
+	FILE*			text;				/* Text trace, NULL if binary */
+	struct trace_record	lookahead;
+	int			has_lookahead;
+	int			finished;
+	int			untimed;			/* No timestep records (text traces of older versions) */
+} TraceSource;
+
+TraceSource*		sources;
+
+/*	Next trace file to be processed (whole table mode) */
+pthread_mutex_t		next_lp_lock = PTHREAD_MUTEX_INITIALIZER;
+int			next_lp = 0;
+
+/*	Command-line parameters */
+char*			log_dir;
+int			LPs;
+int			workers = 0;
+unsigned int		window = 0;
+int			kernel = KERNEL_DELAYS;
+
+/*	Output files */
+FILE*			f_ids_file;
+FILE*			f_nodes_file;
+
+/*	Variables used for statistics */
+unsigned long		messages = 0;
+unsigned long		reached_pairs = 0;
+unsigned long		sum_delays = 0;
+float			coverage;
+float			delay;
+
+
+/*
+	Allocation of memory, the execution is terminated in case of failure
+*/
+void *allocate(void *pointer, size_t size) {
+
+	pointer = realloc(pointer, size);
+	if (pointer == NULL) {
+		printf("GET_COVERAGE_PARALLEL: not enough free memory\n");
+		exit(0);
+	}
+
+	return(pointer);
+}
+
+
+/*
+	Size in bytes of a row of the table with the given number of columns
+*/
+size_t row_size(unsigned int size) {
+
+	return ((kernel == KERNEL_BITSET) ? size / 8 : size);
+}
+
+
+/*
+	Allocation (or enlargement) of a row of the table, the new
+	columns are initialized as not reached
+*/
+unsigned char *row_grow(unsigned char *row, unsigned int old_size, unsigned int size) {
+
+	row = allocate(row, row_size(size));
+	memset(row + row_size(old_size), (kernel == KERNEL_BITSET) ? 0 : NOT_REACHED, row_size(size) - row_size(old_size));
+
+	return(row);
+}
+
+
+/*
+	Checks if the table contains all the rows and the columns that
+	are needed by the records (called with the lock held)
+*/
+int table_fits(const struct trace_record *batch, unsigned int count, unsigned int max_node) {
+
+	unsigned int	i, lp, sequence;
+
+
+	if (max_node >= columns)
+		return(0);
+
+	for (i = 0; i < count; i++) {
+
+		lp = MESSAGE_ID_LP(batch[i].message);
+		sequence = MESSAGE_ID_SEQUENCE(batch[i].message);
+
+		if ((sequence >= rows_size[lp]) || (rows[lp][sequence] == NULL))
+			return(0);
+	}
+
+	return(1);
+}
+
+
+/*
+	Enlarges the table to contain all the rows and the columns that
+	are needed by the records (called with the lock held in exclusive mode)
+*/
+void table_grow(const struct trace_record *batch, unsigned int count, unsigned int max_node) {
+
+	unsigned int	i, lp, sequence, size;
+
+
+	// New columns: all the existing rows are enlarged
+	if (max_node >= columns) {
+
+		size = columns ? columns : 1024;
+		while (size <= max_node)	size *= 2;
+
+		for (lp = 0; lp < (1 << MESSAGE_ID_LP_BITS); lp++) {
+
+			for (i = 0; i < rows_size[lp]; i++) {
+
+				if ((rows[lp][i] != NULL) && (rows[lp][i] != FINALIZED)) {
+
+					rows[lp][i] = row_grow(rows[lp][i], columns, size);
+				}
+			}
+		}
+
+		nodes_seen = allocate(nodes_seen, size);
+		memset(nodes_seen + columns, 0, size - columns);
+		columns = size;
+	}
+
+	// New rows
+	for (i = 0; i < count; i++) {
+
+		lp = MESSAGE_ID_LP(batch[i].message);
+		sequence = MESSAGE_ID_SEQUENCE(batch[i].message);
+
+		if (sequence >= rows_size[lp]) {
+
+			size = rows_size[lp] ? rows_size[lp] : 1024;
+			while (size <= sequence)	size *= 2;
+
+			rows[lp] = allocate(rows[lp], size * sizeof(unsigned char *));
+			memset(rows[lp] + rows_size[lp], 0, (size - rows_size[lp]) * sizeof(unsigned char *));
+			generated[lp] = allocate(generated[lp], size);
+			memset(generated[lp] + rows_size[lp], 0, size - rows_size[lp]);
+			birth[lp] = allocate(birth[lp], size * sizeof(unsigned int));
+			rows_size[lp] = size;
+		}
+
+		if (rows[lp][sequence] == NULL) {
+
+			rows[lp][sequence] = row_grow(NULL, 0, columns);
+		}
+	}
+}
+
+
+/*
+	Update of the table with a batch of records: for each (message, node)
+	pair only the smallest delay is considered
+*/
+void table_update(const struct trace_record *batch, unsigned int count) {
+
+	unsigned int	i, lp, sequence, max_node = 0;
+	unsigned char	*cell, current;
+	uint64_t	*word, bit;
+	unsigned long	delays = 0;
+
+
+	if (count == 0)
+		return;
+
+	for (i = 0; i < count; i++) {
+
+		if (batch[i].delay >= NOT_REACHED) {
+			printf("GET_COVERAGE_PARALLEL: message TTL: %d >= %d\n", batch[i].delay, NOT_REACHED);
+			exit(0);
+		}
+
+		if (batch[i].node > max_node)	max_node = batch[i].node;
+	}
+
+	pthread_rwlock_rdlock(&table_lock);
+
+	while (!table_fits(batch, count, max_node)) {
+
+		pthread_rwlock_unlock(&table_lock);
+		pthread_rwlock_wrlock(&table_lock);
+		table_grow(batch, count, max_node);
+		pthread_rwlock_unlock(&table_lock);
+		pthread_rwlock_rdlock(&table_lock);
+	}
+
+	// Other workers can update the same cells (e.g. migration of the nodes)
+	for (i = 0; i < count; i++) {
+
+		lp = MESSAGE_ID_LP(batch[i].message);
+		sequence = MESSAGE_ID_SEQUENCE(batch[i].message);
+
+		if (rows[lp][sequence] == FINALIZED) {
+			printf("GET_COVERAGE_PARALLEL: message identifier: %010u received after the analysis window of %u timesteps, a larger window is needed\n", batch[i].message, window);
+			exit(0);
+		}
+
+		if (batch[i].type == TRACE_GENERATED) {
+
+			__atomic_store_n(&generated[lp][sequence], 1, __ATOMIC_RELAXED);
+			birth[lp][sequence] = current_step;
+
+			if (window) {
+
+				pthread_mutex_lock(&live_lock);
+				if (live_count == live_size) {
+
+					live_size = live_size ? live_size * 2 : 1024;
+					live = allocate(live, live_size * sizeof(unsigned int));
+				}
+				live[live_count++] = batch[i].message;
+				pthread_mutex_unlock(&live_lock);
+			}
+		}
+
+		__atomic_store_n(&nodes_seen[batch[i].node], 1, __ATOMIC_RELAXED);
+
+		if (kernel == KERNEL_BITSET) {
+
+			// The records are in time order, the first reception has the smallest delay
+			word = (uint64_t *)rows[lp][sequence] + (batch[i].node >> 6);
+			bit = (uint64_t)1 << (batch[i].node & 63);
+
+			if (!(__atomic_load_n(word, __ATOMIC_RELAXED) & bit) && !(__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit))
+				delays += batch[i].delay;
+		} else {
+
+			cell = &rows[lp][sequence][batch[i].node];
+			current = __atomic_load_n(cell, __ATOMIC_RELAXED);
+			while ((batch[i].delay < current) &&
+				!__atomic_compare_exchange_n(cell, &current, (unsigned char)batch[i].delay, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+		}
+	}
+
+	pthread_rwlock_unlock(&table_lock);
+
+	if (delays)
+		__atomic_fetch_add(&sum_delays, delays, __ATOMIC_RELAXED);
+}
+
+
+/*
+	Coverage and delay of a message are accounted and its row is released
+	(called when no worker is updating the table)
+*/
+void finalize_message(unsigned int lp, unsigned int sequence) {
+
+	unsigned int	node;
+	unsigned char	*row = rows[lp][sequence];
+	uint64_t	*words = (uint64_t *)row;
+
+
+	fprintf(f_ids_file, "%010u\n", MESSAGE_ID(lp, sequence));
+	messages++;
+
+	// Bitset kernel: the delays have been accounted at the first reception
+	if (kernel == KERNEL_BITSET) {
+
+		for (node = 0; node < columns / 64; node++)
+			reached_pairs += __builtin_popcountll(words[node]);
+
+		free(row);
+		rows[lp][sequence] = FINALIZED;
+		return;
+	}
+
+	for (node = 0; node < columns; node++) {
+
+		if (row[node] < NOT_REACHED) {
+
+			sum_delays += row[node];
+			reached_pairs++;
+		}
+	}
+
+	free(row);
+	rows[lp][sequence] = FINALIZED;
+}
+
+
+/*
+	Streaming mode: the messages generated before the analysis window
+	of the last processed timestep are finalized
+*/
+void finalize_expired(unsigned int step) {
+
+	unsigned int	i, kept = 0, lp, sequence;
+
+
+	if (live_count > live_max)	live_max = live_count;
+
+	for (i = 0; i < live_count; i++) {
+
+		lp = MESSAGE_ID_LP(live[i]);
+		sequence = MESSAGE_ID_SEQUENCE(live[i]);
+
+		if (birth[lp][sequence] + window <= step)
+			finalize_message(lp, sequence);
+		else
+			live[kept++] = live[i];
+	}
+
+	live_count = kept;
+}
+
+
+/*
+	Next record of a text trace file: each "G" line is followed by the
+	"R" line of the creator of the message, they are merged in a single
+	generation record (as in the binary traces). Returns 0 at the end of the file
+*/
+int source_next_text(TraceSource *source, struct trace_record *record) {
+
+	char		buffer[1024];
+	unsigned int	message = 0, pending = 0;
+
+
+	while (fgets(buffer, 1024, source->text) != NULL) {
+
+		if (buffer[0] == 'T') {
+
+			record->type = TRACE_TIMESTEP;
+			record->message = strtoul(buffer + 2, NULL, 10);
+			return(1);
+		}
+
+		if (buffer[0] == 'G') {
+
+			message = strtoul(buffer + 2, NULL, 10);
+			pending = 1;
+			continue;
+		}
+
+		if (buffer[0] != 'R')
+			continue;
+
+		record->node = strtoul(buffer + 2, NULL, 10);
+		record->message = strtoul(buffer + 13, NULL, 10);
+		record->delay = strtoul(buffer + 24, NULL, 10);
+		record->type = TRACE_RECEIVED;
+
+		if (pending) {
+
+			if (record->message != message) {
+				printf("GET_COVERAGE_PARALLEL: malformed trace file %s, the message %010u has no creator\n", source->name, message);
+				exit(0);
+			}
+
+			record->type = TRACE_GENERATED;
+		}
+
+		return(1);
+	}
+
+	return(0);
+}
+
+
+/*
+	Opening of the trace file of a LP, the binary one is used if available
+*/
+void source_open(TraceSource *source, int lp) {
+
+	memset(source, 0, sizeof(TraceSource));
+
+	sprintf(source->name, "%s/SIM_TRACE_%03d.bin", log_dir, lp);
+	if (trace_open(&source->reader, source->name))
+		return;
+
+	sprintf(source->name, "%s/SIM_TRACE_%03d.log", log_dir, lp);
+	source->text = fopen64(source->name, "r");
+	if (source->text == NULL) {
+		printf("GET_COVERAGE_PARALLEL: unable to open the trace file %s\n", source->name);
+		exit(0);
+	}
+	setvbuf(source->text, NULL, _IOFBF, 1 << 20);
+
+	// A timestep record is written before the first record of each timestep,
+	//	the text traces of the older versions of the simulator have none
+	if (source_next_text(source, &source->lookahead)) {
+
+		source->has_lookahead = 1;
+		source->untimed = (source->lookahead.type != TRACE_TIMESTEP);
+	}
+}
+
+
+/*
+	Processing of the records of a trace file up to the given timestep,
+	the first timestep record after it is kept for the next call
+*/
+void source_process(TraceSource *source, unsigned int until_step) {
+
+	struct trace_record		batch[BATCH_RECORDS];
+	const struct trace_record	*record;
+	unsigned int			count = 0;
+
+
+	while (1) {
+
+		if (source->has_lookahead) {
+
+			batch[count] = source->lookahead;
+			source->has_lookahead = 0;
+		} else if (source->text != NULL) {
+
+			if (!source_next_text(source, &batch[count]))
+				break;
+		} else {
+
+			if ((record = trace_next(&source->reader)) == NULL)
+				break;
+			batch[count] = *record;
+		}
+
+		if (batch[count].type == TRACE_TIMESTEP) {
+
+			if (batch[count].message > until_step) {
+
+				source->lookahead = batch[count];
+				source->has_lookahead = 1;
+				table_update(batch, count);
+				return;
+			}
+			continue;
+		}
+
+		if (++count == BATCH_RECORDS) {
+
+			table_update(batch, count);
+			count = 0;
+		}
+	}
+
+	table_update(batch, count);
+	source->finished = 1;
+}
+
+
+/*
+	Closing of the trace file of a LP
+*/
+void source_close(TraceSource *source) {
+
+	if (source->text != NULL)
+		fclose(source->text);
+	else
+		trace_close(&source->reader);
+}
+
+
+/*
+	Worker thread, whole table mode: the trace files are processed one at a time
+*/
+void *worker(void *arg) {
+
+	int	current_lp;
+
+	(void)arg;
+
+	while (1) {
+
+		pthread_mutex_lock(&next_lp_lock);
+		current_lp = next_lp++;
+		pthread_mutex_unlock(&next_lp_lock);
+
+		if (current_lp >= LPs)
+			return(NULL);
+
+		printf("get_coverage_parallel: processing... %s\n", sources[current_lp].name);
+		source_process(&sources[current_lp], UINT_MAX);
+	}
+}
+
+
+/*
+	Worker thread, streaming mode: each worker processes a subset of the
+	trace files, in each step all the trace files are processed up to the
+	same timestep and then the expired messages are finalized
+*/
+void *streaming_worker(void *arg) {
+
+	int		id = (int)(intptr_t)arg, lp;
+	unsigned int	next_step;
+
+
+	while (1) {
+
+		for (lp = id; lp < LPs; lp += workers) {
+
+			if (!sources[lp].finished)
+				source_process(&sources[lp], current_step);
+		}
+
+		if (pthread_barrier_wait(&step_barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+
+			if (window)
+				finalize_expired(current_step);
+
+			// Next timestep in the traces
+			streaming_done = 1;
+			next_step = UINT_MAX;
+			for (lp = 0; lp < LPs; lp++) {
+
+				if (!sources[lp].finished) {
+
+					streaming_done = 0;
+					if (sources[lp].lookahead.message < next_step)
+						next_step = sources[lp].lookahead.message;
+				}
+			}
+			current_step = next_step;
+		}
+
+		pthread_barrier_wait(&step_barrier);
+
+		if (streaming_done)
+			return(NULL);
+	}
+}
+
+
+/*
+	Coverage and delay of the generated messages with respect to the
+	nodes that have been found in the traces, the remaining messages
+	are finalized and the node IDs are written in the output file
+*/
+void compute_coverage_and_delay() {
+
+	unsigned int	lp, sequence, node;
+	unsigned long	nodes = 0;
+
+
+	for (lp = 0; lp < (1 << MESSAGE_ID_LP_BITS); lp++) {
+
+		for (sequence = 0; sequence < rows_size[lp]; sequence++) {
+
+			if ((rows[lp][sequence] == NULL) || (rows[lp][sequence] == FINALIZED))
+				continue;
+
+			if (!generated[lp][sequence]) {
+				printf("GET_COVERAGE_PARALLEL: message identifier: %010u NOT FOUND in the generated messages\n", MESSAGE_ID(lp, sequence));
+				exit(0);
+			}
+
+			finalize_message(lp, sequence);
+		}
+	}
+
+	for (node = 0; node < columns; node++) {
+
+		if (nodes_seen[node]) {
+
+			fprintf(f_nodes_file, "%010u\n", node);
+			nodes++;
+		}
+	}
+
+	if (window)
+		printf("get_coverage_parallel: %lu messages, %lu nodes, at most %u messages in memory\n", messages, nodes, live_max);
+	else
+		printf("get_coverage_parallel: %lu messages, %lu nodes\n", messages, nodes);
+
+	coverage = (float) (reached_pairs * 100) / (nodes * messages);
+	delay = (float) sum_delays / reached_pairs;
+}
+
+
+int main(int argc, char *argv[]) {
+
+	pthread_t	*threads;
+	long		cpus;
+	int		i;
+	FILE*		f_coverage_file;
+	FILE*		f_delay_file;
+
+
+	if (argc < 7) {
+		printf("Usage: %s TRACE_DIR LPS IDS_FILE NODES_FILE COVERAGE_FILE DELAY_FILE [THREADS] [WINDOW] [delays|bitset]\n", argv[0]);
+		exit(1);
+	}
+
+	/*	Command-line parameters */
+	log_dir = argv[1];
+	LPs = atoi(argv[2]);
+	if (argc > 7)
+		workers = atoi(argv[7]);
+	if (argc > 8)
+		window = atoi(argv[8]);
+	if ((argc > 9) && (strcmp(argv[9], "bitset") == 0))
+		kernel = KERNEL_BITSET;
+	else if ((argc > 9) && (strcmp(argv[9], "delays") != 0)) {
+		printf("GET_COVERAGE_PARALLEL: unknown kernel %s\n", argv[9]);
+		exit(1);
+	}
+
+	if (window >= NOT_REACHED) {
+		printf("GET_COVERAGE_PARALLEL: the analysis window must be lower than %d\n", NOT_REACHED);
+		exit(1);
+	}
+
+	if (workers <= 0) {
+
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		workers = ((cpus > 0) && (cpus < LPs)) ? cpus : LPs;
+	}
+	if (workers > LPs)	workers = LPs;
+
+	f_ids_file = fopen(argv[3], "w");
+	f_nodes_file = fopen(argv[4], "w");
+
+	sources = allocate(NULL, LPs * sizeof(TraceSource));
+	for (i = 0; i < LPs; i++)
+		source_open(&sources[i], i);
+
+	threads = allocate(NULL, workers * sizeof(pthread_t));
+
+	// The traces without timestep records are not in time order
+	for (i = 0; i < LPs; i++) {
+
+		if (sources[i].untimed && window) {
+			printf("get_coverage_parallel: WARNING, the trace file %s has no timestep records, the analysis window is ignored and the whole table is kept in memory\n", sources[i].name);
+			window = 0;
+		}
+
+		if (sources[i].untimed && (kernel == KERNEL_BITSET)) {
+			printf("get_coverage_parallel: WARNING, the trace file %s has no timestep records, the delays kernel is used\n", sources[i].name);
+			kernel = KERNEL_DELAYS;
+		}
+	}
+
+	// The bitset kernel requires the traces to be processed in time order
+	if (window || (kernel == KERNEL_BITSET)) {
+
+		pthread_barrier_init(&step_barrier, NULL, workers);
+		for (i = 0; i < workers; i++)
+			pthread_create(&threads[i], NULL, streaming_worker, (void *)(intptr_t)i);
+	} else {
+
+		for (i = 0; i < workers; i++)
+			pthread_create(&threads[i], NULL, worker, NULL);
+	}
+
+	for (i = 0; i < workers; i++)
+		pthread_join(threads[i], NULL);
+
+	for (i = 0; i < LPs; i++)
+		source_close(&sources[i]);
+
+	compute_coverage_and_delay();
+
+	fclose(f_ids_file);
+	fclose(f_nodes_file);
+
+	f_coverage_file = fopen(argv[5], "a");
+	fprintf(f_coverage_file, "%.2f\n", coverage);
+	fclose(f_coverage_file);
+
+	f_delay_file = fopen(argv[6], "a");
+	fprintf(f_delay_file, "%.2f\n", delay);
+	fclose(f_delay_file);
+
+	return(0);
+}
@@ -0,0 +1,52 @@
+/*	##############################################################################################
+	Advanced RTI System, ARTÌS			http://pads.cs.unibo.it
+	Large Unstructured NEtwork Simulator (LUNES)
+
+	Description:
+		-	Binary format of the graph definition files (network topology),
+			it is produced by the dot2csr tool and mapped in memory by the LPs
+
+	Authors:
+		First version by Gabriele D'Angelo <g.dangelo@unibo.it>
+
+	############################################################################################### */
+
+#ifndef __GRAPH_FORMAT_H
+#define __GRAPH_FORMAT_H
+
+#include <stdint.h>
+
+// The graph is undirected and stored in compressed sparse row (CSR) format:
+//
+//	header						(struct graph_header)
+//	offsets		[vertices + 1] x uint64_t	(neighbors of vertex v are in [offsets[v], offsets[v + 1]))
+//	neighbors	[entries] x uint32_t		(each edge appears twice, once for each endpoint)
+//	original	[vertices] x uint32_t		(only if relabeled: ID of each vertex in the dot file)
+//
+// The neighbors of each vertex are sorted and unique, self loops are not allowed.
+// The vertices can be relabeled by the converter (e.g. partitioning), in this case
+// the simulator uses the new IDs but the traces report the original ones.
+// All the fields are in the byte order of the host that created the file, the
+// magic number is used to detect files that have been created on other architectures
+//
+#define GRAPH_MAGIC		0x5253434CU			// "LCSR" in little-endian
+#define GRAPH_VERSION		2				// Version of the binary format
+
+// Header of the binary graph files
+struct graph_header {
+	uint32_t	magic;						// GRAPH_MAGIC
+	uint32_t	version;					// GRAPH_VERSION
+	uint32_t	vertices;					// Number of vertices (IDs are in [0, vertices))
+	uint32_t	max_degree;					// Precomputed statistics: max degree in the graph
+	uint64_t	entries;					// Size of the neighbors array (twice the number of edges)
+	uint32_t	parts;						// Number of LPs the vertices have been partitioned for, 0 if not partitioned
+	uint32_t	relabeled;					// 1 if the vertices have been relabeled (the original IDs are stored)
+};
+
+// Sections of a graph file that has been mapped in memory
+#define GRAPH_OFFSETS(base)		((const uint64_t *)((const char *)(base) + sizeof(struct graph_header)))
+#define GRAPH_NEIGHBORS(base, vertices)	((const uint32_t *)(GRAPH_OFFSETS(base) + (vertices) + 1))
+#define GRAPH_ORIGINAL(base, vertices, entries)	(GRAPH_NEIGHBORS(base, vertices) + (entries))
+#define GRAPH_FILE_SIZE(vertices, entries, relabeled)	(sizeof(struct graph_header) + ((uint64_t)(vertices) + 1) * sizeof(uint64_t) + ((uint64_t)(entries) + ((relabeled) ? (vertices) : 0)) * sizeof(uint32_t))
+
+#endif /* __GRAPH_FORMAT_H */
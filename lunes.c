@@ -17,6 +17,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <math.h>
@@ -33,6 +34,8 @@
 #include "lunes.h"
 #include "lunes_constants.h"
 #include "entity_definition.h"
+#include "graph_format.h"
+#include "trace_format.h"
 
 
 /* ************************************************************************ */
@@ -42,6 +45,37 @@
 FILE		*fp_print_trace;		// File descriptor for simulation trace file
 unsigned short	env_max_ttl = MAX_TTL;		// TTL of newly created messages
 
+// Sequence number of the next message generated in this LP (see MESSAGE_ID)
+unsigned int	lp_message_sequence = 0;
+
+// Relabeled graphs (see dot2csr): ID of each SE in the original graph definition
+unsigned int	*original_ids = NULL;
+unsigned int	original_ids_count = 0;
+
+// Binary traces (see trace_format.h): records of the block that has not been written yet
+static struct trace_record	*trace_records = NULL;
+static unsigned char		*trace_buffer = NULL;	// Compact encoding of the block
+static unsigned int		trace_count = 0;
+
+// Online metrics: messages that can still be received, each one with the SEs that have received it
+typedef struct metrics_message {
+	float		birth;					// Generation time of the message
+	unsigned int	words;					// Size of the bitset (64 bit words)
+	uint64_t	reached[];				// Bitset of the SEs that have received the message (by local slot)
+} MetricsMessage;
+
+static GHashTable		*metrics_messages = NULL;	// MetricsMessage by message ID
+static unsigned int		*metrics_slots = NULL;		// Local slot of each SE (by ID), plus 1, 0 if the SE has received no message in this LP
+static unsigned int		metrics_slot_count = 0;		// Number of local slots, the SEs that have received at least a message in this LP
+static unsigned long		metrics_reached = 0;		// Number of (message, SE) pairs that have been reached
+static unsigned long		metrics_delays = 0;		// Sum of the delays of the first receptions
+static unsigned long		metrics_late = 0;		// Receptions after the window, not accounted
+static unsigned long		metrics_histogram[METRICS_HISTOGRAM_SIZE];	// Delays of the first receptions
+
+// Timestep of the last record in the trace, a timestep record is written when it changes
+static unsigned int		trace_timestep = 0;
+static unsigned int		trace_timestep_valid = 0;
+
 
 /* ************************************************************************ */
 /* 			E X T E R N A L     V A R I A B L E S 	            */
@@ -54,11 +88,24 @@ extern TSeed		Seed, *S;			/* Seed used for the random generator */
 extern char		*TESTNAME;			/* Test name */
 extern int	     	NSIMULATE;	 		/* Number of Interacting Agents (Simulated Entities) per LP */
 extern int		NLP; 				/* Number of Logical Processes */
+extern int		LPID;				/* Identification number of the local Logical Process */
 // Simulation control
 extern unsigned short	env_dissemination_mode;		/* Dissemination mode */
 extern float 		env_broadcast_prob_threshold;	/* Dissemination: conditional broadcast, probability threshold */
 extern unsigned int	env_cache_size;			/* Cache size of each node */
+extern unsigned int	env_local_links;		/* Both the directions of each edge are built at load time */
+extern unsigned int	env_trace_format;		/* Format of the dissemination trace files */
+extern unsigned int	env_dissemination_trace;	/* The dissemination trace files are written */
+extern unsigned int	env_trace_first_receptions;	/* Only the first receptions are traced */
+extern unsigned int	env_online_metrics;		/* Coverage and delay are computed during the run */
+extern unsigned int	env_online_metrics_window;	/* Online metrics: timesteps in which a message can be received */
 extern float		env_fixed_prob_threshold;	/* Dissemination: fixed probability, probability threshold */
+extern unsigned int	env_fixed_prob_skip_sampling;	/* Dissemination: fixed probability, geometric skip sampling */
+extern unsigned int	env_fanout;			/* Dissemination: fixed fanout, number of neighbors */
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+extern float		env_pull_period;		/* Dissemination: two-phase gossip, timesteps between two digests */
+extern unsigned int	env_pull_max_age;		/* Dissemination: two-phase gossip, max age of the pulled messages */
+#endif
 #ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 extern unsigned int	env_probability_function;   	/* Probability function for Degree Dependent Gossip */
 extern double		env_function_coefficient;   	/* Coefficient of the probability function */
@@ -77,6 +124,7 @@ extern double		env_function_coefficient;   	/* Coefficient of the probability fu
 void	lunes_execute_stimulus (double ts, hash_node_t *src, hash_node_t *dest, int sender) {
 
 	StimulusMsg		msg;			// Message
+	unsigned char		buffer[WIRE_STIMULUS_MAX_SIZE];	// Encoded message
 	unsigned int		message_size;		// Size
 
 
@@ -86,8 +134,8 @@ void	lunes_execute_stimulus (double ts, hash_node_t *src, hash_node_t *dest, int
 	// Inserting the ID of the sender of which this node is missing messages
 	msg.stimulus_static.missing_sender = sender;
 
-	// To reduce the network overhead, only the used part of the message is really sent
-	message_size = sizeof(struct _stimulus_static_part);
+	// To reduce the network overhead, the message is sent in the packed wire format
+	message_size = wire_encode_stimulus(buffer, &msg.stimulus_static);
 
 	// Buffer check
 	if (message_size > BUFFER_SIZE) {
@@ -98,7 +146,7 @@ void	lunes_execute_stimulus (double ts, hash_node_t *src, hash_node_t *dest, int
 	}
 
 	// Real send
-	GAIA_Send (src->data->key, dest->data->key, ts, (void *)&msg, message_size);
+	GAIA_Send (src->dir->key, dest->dir->key, ts, (void *)buffer, message_size);
 }
 #endif
 
@@ -110,20 +158,36 @@ void	lunes_execute_stimulus (double ts, hash_node_t *src, hash_node_t *dest, int
  */
 void lunes_stimuli (hash_node_t *node) {
 	int		sender = 0;		// Checked node (sender)
-	int		forwarder;		// Tmp, checked forwarder
+	HistorySender	*history;		// History of the messages produced by the checked node
 	int 		max_forwarder;		// Best forwarder of the messages produced by a given node
-	int		max_value;		// Max number of messages forwarded by a given forwarder
 	int		tot_received;		// Total number of received messages (from all forwarders)
 	float		theoretical_rate;	// Theoretical rate of reception of each message
 	//
 	unsigned int 	destination;		// Stimulus destination (node identifier)
 	hash_node_t	*receiver;		// Stimulus destination (node in the hash table)
+	value_element	*neighbor;		// Stimulus destination (in the table of neighbors)
 	//
-	char		*dest_table;		// Table of all the possible receivers of stimuli
+	static char	*dest_table = NULL;	// Table of the neighbors that already received a stimulus
+	static unsigned int dest_table_size = 0;
 
-	
-	// Table used to limit the number of stimuli sent to a given node
-	dest_table = calloc(sizeof(char), table->size);
+
+	// Table used to limit the number of stimuli sent to a given node, the destinations
+	//	are neighbors and therefore it is indexed by position in the table of neighbors
+	if ( node->data->degree > dest_table_size ) {
+
+		dest_table_size = node->data->degree;
+		dest_table = realloc(dest_table, dest_table_size * sizeof(char));
+		if ( dest_table == NULL ) {
+
+			fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the table of stimuli destinations\n", simclock);
+			fflush(stdout);
+			exit(-1);
+		}
+	}
+	if ( node->data->degree > 0 )	memset(dest_table, 0, node->data->degree * sizeof(char));
+
+	// What's the theoretical rate of reception of each produced message?
+	theoretical_rate = (float)( ADAPTIVE_GOSSIP_EVALUATION_PERIOD / MEAN_NEW_MESSAGE );
 
 	// I've to check the reception rate from all nodes in the network
 	while ( sender < table->size ) {
@@ -131,28 +195,20 @@ void lunes_stimuli (hash_node_t *node) {
 		// This node should not check for the receiving of messages produced by itself
 		if ( sender != node->data->key) {
 
-			// Looking for the "max forwarder" of a given message (identified by the producer ID)
-			max_forwarder	= -1;
-			max_value	= 0;
-			tot_received	= 0;	// I've to calculate this value for each sender (producer ID)
+			// The total and the "max forwarder" of the messages produced by a given sender
+			//	are updated at each reception, no history means no messages received
+			history = g_hash_table_lookup (node->data->history, &sender);
 
-			// Checking all forwarders, theoretically all the other nodes could be forwarders
-			for ( forwarder = 0; forwarder < table->size; forwarder++) {
+			if ( history != NULL ) {
 
-				// Updating the total number of received messages from a given sender
-				tot_received += node->data->s_state.histable[sender][forwarder];
-
-				// If there's a new max then update some cursors
-				if ( node->data->s_state.histable[sender][forwarder] > max_value ) {
+				tot_received	= history->total;
+				max_forwarder	= history->best_forwarder;
+			} else {
 
-					max_value = node->data->s_state.histable[sender][forwarder];
-					max_forwarder = forwarder;
-				}
+				tot_received	= 0;
+				max_forwarder	= -1;
 			}
 
-			// What's the theoretical rate of reception of each produced message?
-			theoretical_rate = (float)( ADAPTIVE_GOSSIP_EVALUATION_PERIOD / MEAN_NEW_MESSAGE );
-
 			// I've to check if the reception rate is lower than the threshold
 			if ( tot_received < theoretical_rate ) {
 
@@ -163,32 +219,32 @@ void lunes_stimuli (hash_node_t *node) {
 				if ( max_forwarder == -1 ) {
 					// This node has missed all the messages from a given source and therefore
 					// the stimulus destination is chosen at random from the neighbors
-					destination = *(unsigned int *)hash_table_random_key(node->data->state);
+					destination = node->data->neighbors[RND_Integer(S, (double) 1, (double) node->data->degree) - 1];
 				} else {
 					// Some messages has been received and therefore the best forwarder is
 					// destination of the stimulus
 					destination = max_forwarder;
 				}
 
+				// Validity check, the destination must be a neighbor!
+				if ( ( neighbor = lunes_neighbor_lookup (node, destination) ) == NULL) {
+
+					fprintf(stdout, "%12.2f FATAL ERROR, the chosen destination node [%5d] for the stimulus is not a neighbor!!!\n", simclock, destination);
+					fflush(stdout);
+					exit(-1);
+				}
+
 				// In the ADAPTIVE_GOSSIP (alg. #1) dissemination it's possible to send only
 				// one stimulus to a sender in evaluation session
-				if ( dest_table[destination] == 0 ) {
+				if ( dest_table[neighbor - node->data->neighbors_data] == 0 ) {
 
 					// No stimuli sent or another adaptive algorithm is used
-					if ( env_dissemination_mode == ADAPTIVE_GOSSIP )	dest_table[destination] = 1;	// no more stimuli
+					if ( env_dissemination_mode == ADAPTIVE_GOSSIP )	dest_table[neighbor - node->data->neighbors_data] = 1;	// no more stimuli
 
 					#ifdef AG_DEBUG
 					fprintf(stdout, "%12.2f node: [%5d], the stimulus destination is [%5d]\n", simclock, node->data->key, destination);
 					#endif
 
-					// Validity check, the destination must be a neighbor!
-					if (g_hash_table_lookup (node->data->state, &destination) == NULL) {
-
-						fprintf(stdout, "%12.2f FATAL ERROR, the chosen destination node [%5d] for the stimulus is not a neighbor!!!\n", simclock, destination);
-						fflush(stdout);
-						exit(-1);
-					}
-
 					// Looking up the destination node in the global hashtable
 					receiver = hash_lookup(table, destination);
 
@@ -214,14 +270,99 @@ void lunes_stimuli (hash_node_t *node) {
 
 
 #ifdef ADAPTIVE_GOSSIP_SUPPORT
+/*
+	Frees the history of a sender, it is the cleaning function of the history table
+*/
+static void lunes_history_sender_free (gpointer data) {
+
+	HistorySender	*history = (HistorySender *) data;
+
+
+	free (history->forwarders);
+	free (history);
+}
+
+
+/*
+	Creates the (empty) table of received messages of a node
+*/
+static void lunes_history_init (hash_node_t *node) {
+
+	// The key is in the value (the sender ID), only the value has to be freed
+	node->data->history = g_hash_table_new_full (g_int_hash, g_int_equal, NULL, lunes_history_sender_free);
+}
+
+
 /*
 	Updates the table of received messages, used to check the reception rate
 */
 void lunes_histable_update (hash_node_t *node, unsigned int sender_id, unsigned int forwarder_id) {
 
+	HistorySender		*history;
+	HistoryForwarder	*entry = NULL;
+	unsigned int		i;
+
+
+	// First message from this sender in the evaluation period
+	if ( ( history = g_hash_table_lookup (node->data->history, &sender_id) ) == NULL ) {
+
+		history = calloc (1, sizeof(HistorySender));
+		if ( history == NULL ) {
+
+			fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the history of received messages\n", simclock);
+			fflush(stdout);
+			exit(-1);
+		}
+		history->sender = sender_id;
+		history->best_forwarder = -1;
+
+		g_hash_table_insert (node->data->history, &(history->sender), history);
+	}
+
+	// The forwarders are the neighbors of the node, usually a few of them
+	for ( i = 0; i < history->used; i++ ) {
+
+		if ( history->forwarders[i].forwarder == forwarder_id ) {
+
+			entry = &(history->forwarders[i]);
+			break;
+		}
+	}
+
+	// First message from this forwarder
+	if ( entry == NULL ) {
+
+		if ( history->used == history->size ) {
+
+			history->size = ( history->size == 0 ) ? 4 : 2 * history->size;
+			history->forwarders = realloc (history->forwarders, history->size * sizeof(HistoryForwarder));
+			if ( history->forwarders == NULL ) {
+
+				fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the history of received messages\n", simclock);
+				fflush(stdout);
+				exit(-1);
+			}
+		}
+
+		entry = &(history->forwarders[history->used++]);
+		entry->forwarder = forwarder_id;
+		entry->count = 0;
+	}
+
 	// Overflow hack
-	if ( node->data->s_state.histable[sender_id][forwarder_id] < 254 )
-		node->data->s_state.histable[sender_id][forwarder_id]++;
+	if ( entry->count < 254 ) {
+
+		entry->count++;
+
+		// The total and the best forwarder are kept up to date, the counts
+		//	only grow and therefore the best forwarder can only be overtaken
+		history->total++;
+		if ( ( entry->count > history->best_count ) || ( ( entry->count == history->best_count ) && ( (int)forwarder_id < history->best_forwarder ) ) ) {
+
+			history->best_count = entry->count;
+			history->best_forwarder = forwarder_id;
+		}
+	}
 
 	#ifdef DEBUG
 	fprintf(stdout, "%12.2f node: [%5d] updating node adaptive gossip statistics, sender: [%5d], forwarder: [%5d]\n", simclock, node->data->key, sender_id, forwarder_id);
@@ -230,453 +371,1562 @@ void lunes_histable_update (hash_node_t *node, unsigned int sender_id, unsigned
 #endif
 
 
+#ifdef ADAPTIVE_GOSSIP_SUPPORT
 /*
-	Finds the oldest element in the cache, that is the one with the lowest value
-	in the age field
+	Hash and equality functions of the table of active stimuli (by neighbor and cursor)
 */
-int	lunes_cache_find_oldest (CacheElement *cache) {
+static guint lunes_stimulus_hash (gconstpointer key) {
 
-	int	position = -1;
-	int	minimum = MAXINT;
-	int	tmp;
+	const StimulusElement	*stimulus = (const StimulusElement *) key;
 
-	for (tmp = 0; tmp < env_cache_size; tmp++)
-		if (cache[tmp].age < minimum) {
-			minimum = cache[tmp].age;
-			position = tmp;
-		}
 
-	return(position);
+	return( ( stimulus->neighbor * 2654435761U ) ^ stimulus->cursor );
+}
+
+static gboolean lunes_stimulus_equal (gconstpointer a, gconstpointer b) {
+
+	const StimulusElement	*x = (const StimulusElement *) a;
+	const StimulusElement	*y = (const StimulusElement *) b;
+
+
+	return( ( x->neighbor == y->neighbor ) && ( x->cursor == y->cursor ) );
 }
 
 
 /*
-	Inserts a new value in the local cache of a given node
+	Creates the (empty) table of active stimuli of a node
 */
-void lunes_cache_insert(CacheElement *cache, unsigned long value) {
+static void lunes_stimuli_init (hash_node_t *node) {
 
-	// Finds the oldest message in the cache
-	int tmp = lunes_cache_find_oldest(cache);
-
-	// Inserts the new message in the cache
-	cache[tmp].element = value;
-	cache[tmp].age = simclock;
+	// The key is the stimulus itself, only the value has to be freed
+	node->data->stimuli = g_hash_table_new_full (lunes_stimulus_hash, lunes_stimulus_equal, NULL, free);
 }
 
 
 /*
-	Boolean, verifies if the received message is already in the local cache of the node
+	Returns the stimulus that is active for a given neighbor and cursor (NULL if none),
+	the expired stimuli are removed
 */
-int lunes_cache_verify(CacheElement *cache, unsigned long value) {
+static StimulusElement *lunes_stimulus_lookup (hash_node_t *node, unsigned int neighbor, unsigned int cursor) {
 
-	int retvalue = 0;
-	int tmp;
+	StimulusElement		key, *stimulus;
 
 
-	for ( tmp = 0; tmp < env_cache_size; tmp++ )
-		if ( cache[tmp].element == value ) {
+	// Usually no stimuli are active
+	if ( g_hash_table_size (node->data->stimuli) == 0 )	return(NULL);
 
-			retvalue = 1;
-			cache[tmp].age = simclock;
+	key.neighbor = neighbor;
+	key.cursor = cursor;
 
-			break;
-		}
+	if ( ( stimulus = g_hash_table_lookup (node->data->stimuli, &key) ) == NULL )	return(NULL);
+
+	// Lazy expiry
+	if ( stimulus->timeout <= simclock ) {
+
+		g_hash_table_remove (node->data->stimuli, stimulus);
+		return(NULL);
+	}
 
-	return(retvalue);
+	return(stimulus);
 }
 
 
-#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 /*
-	Used to calculate the forwarding probability value for a given node
+	Inserts a new stimulus for a given neighbor and cursor, it has to be not active
 */
-double lunes_degdependent_prob(unsigned int deg)
-{
-	double prob = 0.0;
-		
-	switch (env_probability_function)
-	{
-		// Function 2
-		case 2:
-			prob = 1.0/log(env_function_coefficient * deg);
-		break;
+static StimulusElement *lunes_stimulus_insert (hash_node_t *node, unsigned int neighbor, unsigned int cursor) {
 
-		// Function 1
-		case 1:
-			prob = 1.0/pow(deg, env_function_coefficient);
-		break;
+	StimulusElement		*stimulus;
 
-		default:
-			fprintf(stdout, "%12.2f FATAL ERROR, function: %d does NOT exist!\n", simclock, env_probability_function);
-			fflush(stdout);
-			exit(-1);
-		break;
+
+	// An expired stimulus could be still in the table, it is replaced
+	if ( ( stimulus = malloc (sizeof(StimulusElement)) ) == NULL ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the table of stimuli\n", simclock);
+		fflush(stdout);
+		exit(-1);
 	}
 
-	/*
-		The probability is defined in the range [0, 1], to get full dissemination some functions require that the negative
-		results are treated as "true" (i.e. 1)
-	*/
-	if ( (prob < 0) || (prob > 1) )
-		prob = 1;
+	stimulus->neighbor = neighbor;
+	stimulus->cursor = cursor;
 
-	return prob;
+	g_hash_table_replace (node->data->stimuli, stimulus, stimulus);
+
+	return(stimulus);
 }
-#endif
+
 
 /*
-	Used to forward a received message to (some of) the neighbors of a given node
+	Used to remove all the expired stimuli from the table
 */
-void lunes_real_forward (hash_node_t *node, long value_to_send, unsigned short ttl, double timestamp, unsigned int creator, unsigned int forwarder) {
+static gboolean lunes_stimulus_expired (gpointer key, gpointer value, gpointer data) {
 
-	// Iterator to scan the whole state hashtable of neighbors
-	GHashTableIter		iter;
-	gpointer		key, destination;
-	//
-	float			threshold;		// Tmp, used for probabilistic-based dissemination algorithms
-	//
-	hash_node_t		*sender, *receiver;	// Sender and receiver nodes in the global hashtable
+	return( ((StimulusElement *) value)->timeout <= simclock );
+}
 
 
-	// Dissemination mode for the forwarded messages (dissemination algorithm)
-	switch ( env_dissemination_mode ) {
+/*
+	Copies the active stimuli of a migrating node in the migration message,
+	returns the number of copied stimuli
+*/
+unsigned int lunes_stimuli_pack (hash_node_t *node, unsigned char *buffer, unsigned int max) {
 
-		case BROADCAST:			// Probabilistic broadcast dissemination
+	GHashTableIter		iter;
+	gpointer		key, value;
+	unsigned int		count = 0;
 
-			// The message is forwarded to ALL neighbors of this node
-			// NOTE:	in case of probabilistic broadcast dissemination this function is called
-			//		only if the probabilities evaluation was positive
-			
-			g_hash_table_iter_init (&iter, node->data->state);
 
-			// All neighbors
-			while (g_hash_table_iter_next (&iter, &key, &destination)) {
+	g_hash_table_foreach_remove (node->data->stimuli, lunes_stimulus_expired, NULL);
 
-					sender = hash_lookup(stable, node->data->key);				// This node
-					receiver = hash_lookup(table, *(unsigned int *)destination);		// The neighbor
+	if ( g_hash_table_size (node->data->stimuli) > max ) {
 
-					// The original forwarder of this message and its creator are exclueded 
-					// from this dissemination
-					if ( ( receiver->data->key != forwarder ) && ( receiver->data->key != creator) )
-						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
-			}
-		break;
+		fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d] has too many active stimuli to be migrated\n", simclock, node->data->key);
+		fflush(stdout);
+		exit(-1);
+	}
 
-		case GOSSIP_FIXED_PROB:		// Fixed probability dissemination
+	g_hash_table_iter_init (&iter, node->data->stimuli);
 
-			// In this case, all neighbors will be analyzed but the message will be
-			// forwarded only to some of them			
+	// The records in the buffer could be not aligned
+	while ( g_hash_table_iter_next (&iter, &key, &value) )
+		memcpy (buffer + ( count++ * sizeof(StimulusElement) ), value, sizeof(StimulusElement));
 
-			g_hash_table_iter_init (&iter, node->data->state);
+	return(count);
+}
 
-			// All neighbors
-			while (g_hash_table_iter_next (&iter, &key, &destination)) {
 
-				// Probabilistic evaluation
-				threshold = RND_Interval (S, (double)0, (double)100);
+/*
+	Rebuilds the table of active stimuli of a migrated node
+*/
+static void lunes_stimuli_unpack (hash_node_t *node, const unsigned char *buffer, unsigned int count) {
 
-				if ( threshold <= env_fixed_prob_threshold ) {
+	StimulusElement		record;
+	unsigned int		i;
 
-					sender = hash_lookup(stable, node->data->key);				// This node
-					receiver = hash_lookup(table, *(unsigned int *)destination);		// The neighbor
 
-					// The original forwarder of this message and its creator are exclueded 
-					// from this dissemination
-					if ( ( receiver->data->key != forwarder ) && ( receiver->data->key != creator) )
-						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
-				}
-			}
-		break;
+	for ( i = 0; i < count; i++ ) {
 
-		#ifdef ADAPTIVE_GOSSIP_SUPPORT
-		// Adaptive protocols
-		case ADAPTIVE_GOSSIP:		// Adaptive dissemination, alg. #1 (adaptive node)
-		case ADAPTIVE_GOSSIP_SENDER:	// Adaptive dissemination, alg. #2 (adaptive sender)
-		case ADAPTIVE_GOSSIP_SPECIFIC:	// Adaptive dissemination, alg. #3 (adaptive specific)
+		// The key has to be set before the insertion
+		memcpy (&record, buffer + ( i * sizeof(StimulusElement) ), sizeof(StimulusElement));
 
-			// In this case, all neighbors will be analyzed but the message will be
-			// forwarded only to some of them
+		*lunes_stimulus_insert (node, record.neighbor, record.cursor) = record;
+	}
+}
+#endif
 
-			g_hash_table_iter_init (&iter, node->data->state);
 
-			// All neighbors
-			while (g_hash_table_iter_next (&iter, &key, &destination)) {
+/* -----------------------   DUPLICATE SUPPRESSION CACHE --------------------- */
 
-				value_element	*value;
-				float		adaptive_prob_threshold;
-				unsigned int	keyval;
-				int		residual_window;
-				float		residual_stimulus;
-				int		cursor;
 
+// End of the recency list
+#define CACHE_NONE	0xFFFF
 
-				// In the adaptive gossip (alg. #1) the stimulus is associated to
-				// the node and therefore only one stimulus can be concurrently
-				// active in a given node.
-				//
-				// This is not true in the other gossip protocols (algs. #2 and #3),
-				// in this case each node have to take care of many concurrent stimuli
-				if ( env_dissemination_mode == ADAPTIVE_GOSSIP )
-					cursor = 0;
-				else	cursor = creator;
 
+/*
+	Position in the cache index of a given element (multiplicative hashing)
+*/
+static inline unsigned int lunes_cache_hash (unsigned int value) {
 
-				// Numeric identificator of the (possible) destination node
-				keyval = *(unsigned int *)destination;
-				// Extra information linked to the (possible) destination node
-				value = (value_element *) g_hash_table_lookup (node->data->state, &keyval);
+	return ( ( value * 2654435761U ) >> ( 32 - CACHE_INDEX_BITS ) );
+}
 
-				// If the stimulus timeout has expired (there is no more stimulus residual) or
-				// if there has never been a stimulus before then the new dissemination probability
-				// is the standard one (that is, the same of the fixed probability dissemination)
-				if ( ( value->stim_timeout[cursor] <= simclock ) || ( value->stim_timeout[cursor] == 0 ) ) {
 
-					adaptive_prob_threshold =  env_fixed_prob_threshold;
+/*
+	Detaches a slot from the recency list of the cache
+*/
+static void lunes_cache_unlink (Cache *cache, unsigned short slot) {
 
-				} else {
+	CacheElement	*element = &(cache->slots[slot]);
 
-					// If a stimulus is already active then I've to calculate what is the
-					// residual stimulus and add it to the baseline dissemination probability
 
-					residual_window = (int) ( value->stim_timeout[cursor] - simclock ); 
+	if ( element->newer != CACHE_NONE )	cache->slots[element->newer].older = element->older;
+	else					cache->newest = element->older;
 
-					residual_stimulus = ( value->stim_increment[cursor] * residual_window ) / STIMULUS_LENGTH;
+	if ( element->older != CACHE_NONE )	cache->slots[element->older].newer = element->newer;
+	else					cache->oldest = element->newer;
+}
 
-					adaptive_prob_threshold =  env_fixed_prob_threshold + residual_stimulus;
-				}
 
-				#ifdef AG_DEBUG
-				if ( adaptive_prob_threshold > env_fixed_prob_threshold )
-					fprintf(stdout, "%12.2f node: [%5d] neighbor [%5d] with adaptive threshold: %3.2f, increment %3.2f, residual %3.2f\n", simclock, node->data->key, *(unsigned int *)destination, adaptive_prob_threshold, value->stim_increment[cursor], residual_stimulus);
-				#endif
+/*
+	Places a slot in front of the recency list of the cache (most recently used)
+*/
+static void lunes_cache_push_newest (Cache *cache, unsigned short slot) {
 
-				// Probabilistic evaluation
-				threshold = RND_Interval (S, (double)0, (double)100);
+	cache->slots[slot].newer = CACHE_NONE;
+	cache->slots[slot].older = cache->newest;
 
-				if ( threshold <= adaptive_prob_threshold ) {
+	if ( cache->newest != CACHE_NONE )	cache->slots[cache->newest].newer = slot;
+	else					cache->oldest = slot;
 
-					sender = hash_lookup(stable, node->data->key);				// This node
-					receiver = hash_lookup(table, *(unsigned int *)destination);		// The neighbor
+	cache->newest = slot;
+}
 
-					// The original forwarder of this message and its creator are exclueded 
-					// from this dissemination
-					if ( ( receiver->data->key != forwarder ) && ( receiver->data->key != creator) )
-						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
-				}
-			}
-		break;
-		#endif
 
-		#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
-		// Degree Dependent dissemination algorithm
-		case DEGREE_DEPENDENT_GOSSIP: 
+/*
+	Removes a slot from the cache index, the following buckets of the same
+	probing sequence are shifted backward to keep the lookups correct
+*/
+static void lunes_cache_index_remove (Cache *cache, unsigned short slot) {
 
-			g_hash_table_iter_init (&iter, node->data->state);
+	unsigned int	hole, bucket, home;
 
-			// All neighbors
-			while (g_hash_table_iter_next (&iter, &key, &destination)) 
-			{
-				sender = hash_lookup(stable, node->data->key);				// This node
-				receiver = hash_lookup(table, *(unsigned int *)destination);		// The neighbor
 
-				// The original forwarder of this message and its creator are excluded 
-				// from this dissemination
-				if ( ( receiver->data->key != forwarder ) && ( receiver->data->key != creator) )
-				{
-					// Probabilistic evaluation
-					threshold = (RND_Interval (S, (double)0, (double)100)) / 100;
+	// Looking for the bucket that refers to the slot
+	hole = lunes_cache_hash(cache->slots[slot].element);
+	while ( cache->index[hole] != slot + 1 )
+		hole = ( hole + 1 ) & ( CACHE_INDEX_SIZE - 1 );
 
-					// If the eligible recipient has less than 3 neighbors, its reception probability is 1. However,
-					// if its value of num_neighbors is 0, it means that I don't know the dimension of 
-					// that node's neighborhood, so the threshold is set to 1/n, being n 
-					// the dimension of my neighborhood
+	cache->index[hole] = 0;
 
-					if (((value_element *)destination)->num_neighbors < 3)
-					{
-						// Note that, the startup phase (when the number of neighbors is not known) falls in
-						// this case (num_neighbors = 0)
-						// -> full dissemination
-						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
-					}
-					// Otherwise, the probability is evaluated according to the function defined by the
-					// environment variable env_probability_function
-					else
-					{
-						if (threshold <= lunes_degdependent_prob(((value_element *)destination)->num_neighbors))
-							execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
-					}
-				}
-			}
+	// Backward shift of the following entries of the cluster
+	bucket = hole;
+	while ( cache->index[bucket = ( bucket + 1 ) & ( CACHE_INDEX_SIZE - 1 )] ) {
 
-		break;
-		#endif
+		home = lunes_cache_hash(cache->slots[cache->index[bucket] - 1].element);
 
-		default:
+		// The entry can be moved in the hole only if its home bucket is not
+		// (cyclically) placed between the hole and the entry itself
+		if ( ( ( bucket - home ) & ( CACHE_INDEX_SIZE - 1 ) ) >= ( ( bucket - hole ) & ( CACHE_INDEX_SIZE - 1 ) ) ) {
 
-			fprintf(stdout, "%12.2f FATAL ERROR, the dissemination mode [%2d] is NOT implemented in this version of LUNES!!!\n", simclock, env_dissemination_mode);
-			fprintf(stdout, "%12.2f NOTE: all the adaptive protocols require compile time support: see the ADAPTIVE_GOSSIP_SUPPORT define in sim-parameters.h\n", simclock);
+			cache->index[hole] = cache->index[bucket];
+			cache->index[bucket] = 0;
+			hole = bucket;
+		}
+	}
+}
+
+
+/*
+	Initializes the (empty) local cache of a given node
+*/
+void lunes_cache_init (Cache *cache) {
+
+	cache->used	= 0;
+	cache->newest	= CACHE_NONE;
+	cache->oldest	= CACHE_NONE;
+
+	memset(cache->index, 0, sizeof(cache->index));
+}
+
+
+/*
+	Inserts a new value in the local cache of a given node,
+	if the cache is full then the oldest element is replaced
+*/
+void lunes_cache_insert (Cache *cache, unsigned long value, float timestamp, unsigned int creator) {
+
+	unsigned short	slot;
+	unsigned int	bucket;
+
+
+	// The cache is disabled
+	if ( env_cache_size == 0 )
+		return;
+
+	if ( cache->used < env_cache_size ) {
+
+		// There is still a free slot
+		slot = cache->used++;
+	} else {
+
+		// Evicting the oldest message in the cache
+		slot = cache->oldest;
+
+		lunes_cache_index_remove(cache, slot);
+		lunes_cache_unlink(cache, slot);
+	}
+
+	// Inserts the new message in the cache
+	cache->slots[slot].element = value;
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	// Needed to send again the message in the pull phase
+	cache->slots[slot].timestamp = timestamp;
+	cache->slots[slot].creator = creator;
+	#endif
+
+	bucket = lunes_cache_hash(value);
+	while ( cache->index[bucket] )
+		bucket = ( bucket + 1 ) & ( CACHE_INDEX_SIZE - 1 );
+
+	cache->index[bucket] = slot + 1;
+
+	lunes_cache_push_newest(cache, slot);
+}
+
+
+/*
+	Slot (plus one) of the message in the local cache of the node, 0 if the
+	message is not cached (the age of the cached element is not modified)
+*/
+static unsigned int lunes_cache_find (Cache *cache, unsigned long value) {
+
+	unsigned int	bucket;
+
+
+	bucket = lunes_cache_hash(value);
+	while ( cache->index[bucket] ) {
+
+		if ( cache->slots[cache->index[bucket] - 1].element == value )
+			return(cache->index[bucket]);
+
+		bucket = ( bucket + 1 ) & ( CACHE_INDEX_SIZE - 1 );
+	}
+
+	return(0);
+}
+
+
+/*
+	Boolean, verifies if the received message is already in the local cache of the node,
+	in this case the message becomes the most recently used element in the cache
+*/
+int lunes_cache_verify (Cache *cache, unsigned long value) {
+
+	unsigned int	found;
+
+
+	if ( ( found = lunes_cache_find(cache, value) ) == 0 )
+		return(0);
+
+	// Refreshing the age of the cached element
+	lunes_cache_unlink(cache, found - 1);
+	lunes_cache_push_newest(cache, found - 1);
+
+	return(1);
+}
+
+
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+/*
+	Two-phase gossip: copies in "slots" the (at most "max") most recently used
+	elements of the cache, returns the number of copied elements
+*/
+static unsigned int lunes_cache_recent (Cache *cache, CacheElement **slots, unsigned int max) {
+
+	unsigned short	slot;
+	unsigned int	count = 0;
+
+
+	for ( slot = cache->newest; ( slot != CACHE_NONE ) && ( count < max ); slot = cache->slots[slot].older )
+		slots[count++] = &(cache->slots[slot]);
+
+	return(count);
+}
+
+
+/*
+	Two-phase gossip: comparison of message IDs, used to sort the received digests
+*/
+static int lunes_digest_compare (const void *a, const void *b) {
+
+	unsigned int	x = *(const unsigned int *)a;
+	unsigned int	y = *(const unsigned int *)b;
+
+
+	return ( ( x > y ) - ( x < y ) );
+}
+#endif
+
+
+#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+/*
+	Used to calculate the forwarding probability value for a given node
+*/
+double lunes_degdependent_prob(unsigned int deg)
+{
+	double prob = 0.0;
+		
+	switch (env_probability_function)
+	{
+		// Function 2
+		case 2:
+			prob = 1.0/log(env_function_coefficient * deg);
+		break;
+
+		// Function 1
+		case 1:
+			prob = 1.0/pow(deg, env_function_coefficient);
+		break;
+
+		default:
+			fprintf(stdout, "%12.2f FATAL ERROR, function: %d does NOT exist!\n", simclock, env_probability_function);
+			fflush(stdout);
+			exit(-1);
+		break;
+	}
+
+	/*
+		The probability is defined in the range [0, 1], to get full dissemination some functions require that the negative
+		results are treated as "true" (i.e. 1)
+	*/
+	if ( (prob < 0) || (prob > 1) )
+		prob = 1;
+
+	return prob;
+}
+
+
+// Probability of each degree that is present in the graph, the probability function
+//	and its coefficient are the same for the whole run
+static double		*degdependent_prob_table	= NULL;
+static unsigned int	degdependent_prob_table_size	= 0;
+
+
+/*
+	Computes once the probability of all the degrees up to the max degree of the graph
+*/
+static void lunes_degdependent_prob_init (unsigned int max_degree)
+{
+	unsigned int	deg;
+
+
+	degdependent_prob_table_size = max_degree + 1;
+	degdependent_prob_table = realloc(degdependent_prob_table, degdependent_prob_table_size * sizeof(double));
+	if ( degdependent_prob_table == NULL ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the table of degree dependent probabilities\n", simclock);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	for ( deg = 0; deg < degdependent_prob_table_size; deg++ ) {
+
+		// Nodes with less than 3 neighbors always receive the message (see lunes_real_forward)
+		if ( deg < 3 )
+			degdependent_prob_table[deg] = 1;
+		else	degdependent_prob_table[deg] = lunes_degdependent_prob(deg);
+	}
+}
+
+
+/*
+	Returns the probability of a given degree, the table is used if the degree is in it
+*/
+static inline double lunes_degdependent_prob_lookup (unsigned int deg)
+{
+	if ( deg < degdependent_prob_table_size )
+		return degdependent_prob_table[deg];
+	else	return lunes_degdependent_prob(deg);
+}
+#endif
+
+/*
+	Geometric skip sampling: returns the number of neighbors to be skipped before the
+	next one that passes the probabilistic evaluation, that is the number of failures
+	before the first success in a sequence of Bernoulli trials.
+	The parameter is log(1 - p), where p is the success probability in (0, 1)
+*/
+static double lunes_geometric_skip (double log_failure) {
+
+	// 1 - U is in (0, 1] and therefore the logarithm is finite
+	return( floor( log( 1.0 - RND_Interval (S, (double)0, (double)1) ) / log_failure ) );
+}
+
+
+/*
+	Fixed fanout: chooses at random env_fanout distinct neighbors of a given node, the forwarder
+	and the creator of the message are excluded. It is the Floyd's sampling algorithm on the
+	positions in the (sorted) table of neighbors, that is not modified. Returns the number of
+	chosen neighbors, their positions are in "chosen" (valid up to the next call)
+*/
+static unsigned int lunes_fanout_sample (hash_node_t *node, unsigned int forwarder, unsigned int creator, unsigned int **chosen) {
+
+	static unsigned int	*positions = NULL;	// Chosen positions, reused by all calls
+	static unsigned int	positions_size = 0;
+	//
+	value_element		*neighbor;
+	unsigned int		excluded[2], excluded_count = 0;
+	unsigned int		eligible, count = 0;
+	unsigned int		i, j, e, t;
+
+
+	// Positions of the excluded neighbors, in ascending order
+	if ( ( neighbor = lunes_neighbor_lookup (node, forwarder) ) )
+		excluded[excluded_count++] = neighbor - node->data->neighbors_data;
+
+	if ( ( creator != forwarder ) && ( neighbor = lunes_neighbor_lookup (node, creator) ) )
+		excluded[excluded_count++] = neighbor - node->data->neighbors_data;
+
+	if ( ( excluded_count == 2 ) && ( excluded[0] > excluded[1] ) ) {
+
+		t = excluded[0];
+		excluded[0] = excluded[1];
+		excluded[1] = t;
+	}
+
+	eligible = node->data->degree - excluded_count;
+
+	if ( ( env_fanout < eligible ? env_fanout : eligible ) > positions_size ) {
+
+		positions_size = env_fanout < eligible ? env_fanout : eligible;
+		positions = realloc(positions, positions_size * sizeof(unsigned int));
+		if ( positions == NULL ) {
+
+			fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the fixed fanout dissemination\n", simclock);
+			fflush(stdout);
+			exit(-1);
+		}
+	}
+
+	// Sampling of the eligible neighbors (numbered from 0 to eligible - 1)
+	if ( env_fanout >= eligible ) {
+
+		// All of them
+		for ( e = 0; e < eligible; e++ )	positions[count++] = e;
+	} else {
+
+		// Floyd's algorithm, env_fanout random draws
+		for ( j = eligible - env_fanout; j < eligible; j++ ) {
+
+			t = RND_Integer (S, (double)0, (double)j);
+
+			// If t has been already chosen then j is chosen (it can not be already chosen)
+			for ( i = 0; ( i < count ) && ( positions[i] != t ); i++ );
+			if ( i < count )	t = j;
+
+			positions[count++] = t;
+		}
+	}
+
+	// From eligible neighbors to positions in the table of neighbors
+	for ( i = 0; i < count; i++ )
+		for ( e = 0; e < excluded_count; e++ )
+			if ( positions[i] >= excluded[e] )	positions[i]++;
+
+	*chosen = positions;
+	return(count);
+}
+
+
+/*
+	Used to forward a received message to (some of) the neighbors of a given node
+*/
+void lunes_real_forward (hash_node_t *node, long value_to_send, unsigned short ttl, double timestamp, unsigned int creator, unsigned int forwarder) {
+
+	// Cursor to scan the compact table of neighbors
+	unsigned int		i;
+	unsigned int		*neighbors = node->data->neighbors;
+	value_element		*neighbors_data = node->data->neighbors_data;
+	dir_data_t		**neighbors_dir = node->data->neighbors_dir;
+	//
+	float			threshold;		// Tmp, used for probabilistic-based dissemination algorithms
+	//
+	hash_node_t		*sender;		// Sender node, that is this node
+	dir_data_t		*receiver;		// Receiver node, directory record of the neighbor
+
+
+	// The sender is the same for all the neighbors
+	sender = node;
+
+	// Dissemination mode for the forwarded messages (dissemination algorithm)
+	switch ( env_dissemination_mode ) {
+
+		case BROADCAST:			// Probabilistic broadcast dissemination
+
+			// The message is forwarded to ALL neighbors of this node
+			// NOTE:	in case of probabilistic broadcast dissemination this function is called
+			//		only if the probabilities evaluation was positive
+			
+			// All neighbors
+			for ( i = 0; i < node->data->degree; i++ ) {
+
+					receiver = neighbors_dir[i];						// The neighbor
+
+					// The original forwarder of this message and its creator are exclueded 
+					// from this dissemination
+					if ( ( neighbors[i] != forwarder ) && ( neighbors[i] != creator) )
+						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
+			}
+		break;
+
+		#ifdef TWO_PHASE_GOSSIP_SUPPORT
+		case TWO_PHASE_GOSSIP:		// Two-phase gossip, the push phase is a fixed probability dissemination
+		#endif
+		case GOSSIP_FIXED_PROB:		// Fixed probability dissemination
+
+			// In this case, all neighbors will be analyzed but the message will be
+			// forwarded only to some of them			
+
+			// The neighbors that pass the probabilistic evaluation are directly reached,
+			// the gap between them is geometrically distributed (one random draw for
+			// each selected neighbor instead of one for each neighbor)
+			if ( env_fixed_prob_skip_sampling && ( env_fixed_prob_threshold < 100 ) ) {
+
+				double	log_failure, position;
+
+
+				// No neighbor can be selected
+				if ( env_fixed_prob_threshold <= 0 )	break;
+
+				log_failure = log( 1.0 - ( env_fixed_prob_threshold / 100.0 ) );
+
+				for ( position = lunes_geometric_skip (log_failure); position < node->data->degree; position += 1 + lunes_geometric_skip (log_failure) ) {
+
+					i = (unsigned int) position;
+
+					receiver = neighbors_dir[i];						// The neighbor
+
+					// The original forwarder of this message and its creator are exclueded 
+					// from this dissemination
+					if ( ( neighbors[i] != forwarder ) && ( neighbors[i] != creator) )
+						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
+				}
+				break;
+			}
+
+			// All neighbors
+			for ( i = 0; i < node->data->degree; i++ ) {
+
+				// Probabilistic evaluation
+				threshold = RND_Interval (S, (double)0, (double)100);
+
+				if ( threshold <= env_fixed_prob_threshold ) {
+
+					receiver = neighbors_dir[i];						// The neighbor
+
+					// The original forwarder of this message and its creator are exclueded 
+					// from this dissemination
+					if ( ( neighbors[i] != forwarder ) && ( neighbors[i] != creator) )
+						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
+				}
+			}
+		break;
+
+		case GOSSIP_FIXED_FANOUT:	// Fixed fanout dissemination
+		{
+			unsigned int	*chosen;
+			unsigned int	count;
+
+
+			// The message is forwarded to env_fanout neighbors chosen at random (or to all of
+			// them if they are less), the original forwarder and the creator are excluded
+			count = lunes_fanout_sample (node, forwarder, creator, &chosen);
+
+			for ( i = 0; i < count; i++ ) {
+
+				receiver = neighbors_dir[chosen[i]];					// The neighbor
+
+				execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
+			}
+		}
+		break;
+
+		#ifdef ADAPTIVE_GOSSIP_SUPPORT
+		// Adaptive protocols
+		case ADAPTIVE_GOSSIP:		// Adaptive dissemination, alg. #1 (adaptive node)
+		case ADAPTIVE_GOSSIP_SENDER:	// Adaptive dissemination, alg. #2 (adaptive sender)
+		case ADAPTIVE_GOSSIP_SPECIFIC:	// Adaptive dissemination, alg. #3 (adaptive specific)
+
+			// In this case, all neighbors will be analyzed but the message will be
+			// forwarded only to some of them
+
+			// All neighbors
+			for ( i = 0; i < node->data->degree; i++ ) {
+
+				StimulusElement	*stimulus;
+				float		adaptive_prob_threshold;
+				int		residual_window;
+				float		residual_stimulus;
+				int		cursor;
+
+
+				// In the adaptive gossip (alg. #1) the stimulus is associated to
+				// the node and therefore only one stimulus can be concurrently
+				// active in a given node.
+				//
+				// This is not true in the other gossip protocols (algs. #2 and #3),
+				// in this case each node have to take care of many concurrent stimuli
+				if ( env_dissemination_mode == ADAPTIVE_GOSSIP )
+					cursor = 0;
+				else	cursor = creator;
+
+
+				// Stimulus linked to the (possible) destination node, in the adaptive
+				// sender (alg. #2) the stimuli are associated to the node
+				if ( env_dissemination_mode == ADAPTIVE_GOSSIP_SENDER )
+					stimulus = lunes_stimulus_lookup (node, 0, cursor);
+				else	stimulus = lunes_stimulus_lookup (node, neighbors[i], cursor);
+
+				// If the stimulus timeout has expired (there is no more stimulus residual) or
+				// if there has never been a stimulus before then the new dissemination probability
+				// is the standard one (that is, the same of the fixed probability dissemination)
+				if ( stimulus == NULL ) {
+
+					adaptive_prob_threshold =  env_fixed_prob_threshold;
+
+				} else {
+
+					// If a stimulus is already active then I've to calculate what is the
+					// residual stimulus and add it to the baseline dissemination probability
+
+					residual_window = (int) ( stimulus->timeout - simclock ); 
+
+					residual_stimulus = ( stimulus->increment * residual_window ) / STIMULUS_LENGTH;
+
+					adaptive_prob_threshold =  env_fixed_prob_threshold + residual_stimulus;
+				}
+
+				#ifdef AG_DEBUG
+				if ( adaptive_prob_threshold > env_fixed_prob_threshold )
+					fprintf(stdout, "%12.2f node: [%5d] neighbor [%5d] with adaptive threshold: %3.2f, increment %3.2f, residual %3.2f\n", simclock, node->data->key, neighbors[i], adaptive_prob_threshold, stimulus->increment, residual_stimulus);
+				#endif
+
+				// Probabilistic evaluation
+				threshold = RND_Interval (S, (double)0, (double)100);
+
+				if ( threshold <= adaptive_prob_threshold ) {
+
+					receiver = neighbors_dir[i];						// The neighbor
+
+					// The original forwarder of this message and its creator are exclueded 
+					// from this dissemination
+					if ( ( neighbors[i] != forwarder ) && ( neighbors[i] != creator) )
+						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
+				}
+			}
+		break;
+		#endif
+
+		#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+		// Degree Dependent dissemination algorithm
+		case DEGREE_DEPENDENT_GOSSIP: 
+
+			// All neighbors
+			for ( i = 0; i < node->data->degree; i++ )
+			{
+				receiver = neighbors_dir[i];						// The neighbor
+
+				// The original forwarder of this message and its creator are excluded 
+				// from this dissemination
+				if ( ( neighbors[i] != forwarder ) && ( neighbors[i] != creator) )
+				{
+					// Probabilistic evaluation
+					threshold = (RND_Interval (S, (double)0, (double)100)) / 100;
+
+					// If the eligible recipient has less than 3 neighbors, its reception probability is 1. However,
+					// if its value of num_neighbors is 0, it means that I don't know the dimension of 
+					// that node's neighborhood, so the threshold is set to 1/n, being n 
+					// the dimension of my neighborhood
+
+					if (neighbors_data[i].num_neighbors < 3)
+					{
+						// Note that, the startup phase (when the number of neighbors is not known) falls in
+						// this case (num_neighbors = 0)
+						// -> full dissemination
+						execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
+					}
+					// Otherwise, the probability is evaluated according to the function defined by the
+					// environment variable env_probability_function
+					else
+					{
+						if (threshold <= lunes_degdependent_prob_lookup(neighbors_data[i].num_neighbors))
+							execute_ping (simclock + FLIGHT_TIME, sender, receiver, ttl, value_to_send, timestamp, creator);
+					}
+				}
+			}
+
+		break;
+		#endif
+
+		default:
+
+			fprintf(stdout, "%12.2f FATAL ERROR, the dissemination mode [%2d] is NOT implemented in this version of LUNES!!!\n", simclock, env_dissemination_mode);
+			fprintf(stdout, "%12.2f NOTE: all the adaptive protocols require compile time support: see the ADAPTIVE_GOSSIP_SUPPORT define in sim-parameters.h\n", simclock);
+			fflush(stdout);
+			exit(-1);
+		break;	
+	}
+}
+
+
+/*
+	Dissemination protocol implementation:
+	a new message has been received from a neighbor, it is necessary to forward it in some way
+*/
+void lunes_forward_to_neighbors (hash_node_t *node, long value_to_send, unsigned short ttl, double timestamp, unsigned int creator, unsigned int forwarder) {
+
+	float	threshold;	// Tmp, probabilistic evaluation
+
+
+	// Dissemination mode for the forwarded messages
+	switch (env_dissemination_mode) {
+
+		case BROADCAST:			// Probabilistic broadcast
+
+			// Probabilistic evaluation
+			threshold = RND_Interval (S, (double)0, (double)100);
+
+			if ( threshold <= env_broadcast_prob_threshold )
+				lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
+		break;
+
+		case GOSSIP_FIXED_PROB:		// Fixed probability dissemination
+
+			lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
+		break;
+
+		case GOSSIP_FIXED_FANOUT:	// Fixed fanout dissemination
+
+			lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
+		break;
+
+		#ifdef TWO_PHASE_GOSSIP_SUPPORT
+		case TWO_PHASE_GOSSIP:		// Two-phase gossip (push phase)
+
+			lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
+		break;
+		#endif
+
+		#ifdef ADAPTIVE_GOSSIP_SUPPORT
+		case ADAPTIVE_GOSSIP:		// Adaptive dissemination, alg. #1 (adaptive node)
+		case ADAPTIVE_GOSSIP_SENDER:	// Adaptive dissemination, alg. #2 (adaptive sender)
+		case ADAPTIVE_GOSSIP_SPECIFIC:	// Adaptive dissemination, alg. #3 (adaptive specific)
+
+			lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
+		break;
+		#endif
+
+		#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+		case DEGREE_DEPENDENT_GOSSIP:
+
+			lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
+		break;
+		#endif
+
+		default:
+
+			fprintf(stdout, "%12.2f FATAL ERROR, the dissemination mode [%2d] is NOT implemented in this version of LUNES!!!\n", simclock, env_dissemination_mode);
+			fprintf(stdout, "%12.2f NOTE: all the adaptive protocols require compile time support: see the ADAPTIVE_GOSSIP_SUPPORT define in sim-parameters.h\n", simclock);
 			fflush(stdout);
 			exit(-1);
-		break;	
+		break;
+	}
+}
+
+
+/*
+	Dissemination protocol implementation:
+	a new message has been generated in this node and now it is propagated to (some) neighbors
+*/
+void lunes_send_to_neighbors (hash_node_t *node, long value_to_send) {
+
+	unsigned int	i;
+
+
+	// All neighbors
+	for ( i = 0; i < node->data->degree; i++ ) {
+
+		// It's a standard ping message
+		execute_ping (simclock + FLIGHT_TIME, node, node->data->neighbors_dir[i], env_max_ttl, value_to_send, simclock, node->data->key);
+	}
+}
+
+
+/* -----------------------   COMPACT NEIGHBORS TABLE (CSR) --------------------- */
+
+// LP-wide compact table of neighbors, each local SE uses a slice of it
+static unsigned int	*csr_neighbors		= NULL;		// IDs of the neighbors
+static value_element	*csr_neighbors_data	= NULL;		// Extra data of each neighbor
+static dir_data_t	**csr_neighbors_dir	= NULL;		// Directory record of each neighbor
+static int		topology_compacted	= 0;		// ON when the topology has been compacted
+
+
+/*
+	Comparison of state records by key, used to sort the compact table of neighbors
+*/
+static int lunes_state_element_compare (const void *a, const void *b) {
+
+	unsigned int	key_a = ((struct state_element *)a)->key;
+	unsigned int	key_b = ((struct state_element *)b)->key;
+
+
+	return( ( key_a > key_b ) - ( key_a < key_b ) );
+}
+
+
+/*
+	Fills the compact table of neighbors of a given node using a set of state records,
+	the records are sorted by key so that neighbors can be found with a binary search.
+	The directory record of each neighbor is resolved here, once for all the forwarding
+*/
+static void lunes_fill_neighbors (hash_node_t *node, struct state_element *records, unsigned int count, unsigned int *neighbors, value_element *neighbors_data, dir_data_t **neighbors_dir) {
+
+	unsigned int	i;
+	hash_node_t	*neighbor;
+
+
+	if ( ( neighbors == NULL ) || ( neighbors_data == NULL ) || ( neighbors_dir == NULL ) ) {
+
+		fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d], memory allocation, impossible to build the compact table of neighbors\n", simclock, node->data->key);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	qsort(records, count, sizeof(struct state_element), lunes_state_element_compare);
+
+	for ( i = 0; i < count; i++ ) {
+
+		neighbors[i]		= records[i].key;
+		neighbors_data[i]	= records[i].elements;
+
+		if ( ( neighbor = hash_lookup(table, records[i].key) ) == NULL ) {
+
+			fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d] the neighbor [%5d] does not exist in the global hashtable of simulated entities!!!\n", simclock, node->data->key, records[i].key);
+			fflush(stdout);
+			exit(-1);
+		}
+
+		neighbors_dir[i]	= neighbor->dir;
+	}
+
+	node->data->degree		= count;
+	node->data->neighbors		= neighbors;
+	node->data->neighbors_data	= neighbors_data;
+	node->data->neighbors_dir	= neighbors_dir;
+}
+
+
+/*
+	Returns the extra data associated to a given neighbor (NULL if it is not a neighbor)
+*/
+value_element * lunes_neighbor_lookup (hash_node_t *node, unsigned int key) {
+
+	unsigned int	low = 0, 
+			high = node->data->degree,
+			middle;
+
+
+	while ( low < high ) {
+
+		middle = ( low + high ) / 2;
+
+		if ( node->data->neighbors[middle] < key )	low = middle + 1;
+		else						high = middle;
+	}
+
+	if ( ( low < node->data->degree ) && ( node->data->neighbors[low] == key ) )
+		return( &(node->data->neighbors_data[low]) );
+	else	return( NULL );
+}
+
+
+/*
+	After the building phase the network topology does not change anymore, the hash table
+	of neighbors of each local SE is replaced by its slice in a LP-wide compact table (CSR)
+	that is scanned linearly by the dissemination protocols
+*/
+void lunes_compact_topology () {
+
+	int			h;
+	hash_node_t		*node;
+	unsigned int		total = 0,		// Total number of neighbors of the local SEs
+				max_degree = 0,		// Max number of neighbors of a local SE
+				offset = 0,
+				count;
+	struct state_element	*records;		// Tmp, records copied from the hash table
+	//
+	GHashTableIter		iter;
+	gpointer		key, value;
+
+
+	// How large is the compact table?
+	for ( h = 0; h < stable->count; h++ ) {
+
+		count = g_hash_table_size(stable->list[h]->data->state);
+
+		total += count;
+		if ( count > max_degree )	max_degree = count;
+	}
+
+	csr_neighbors		= malloc( ( total + 1 ) * sizeof(unsigned int) );
+	csr_neighbors_data	= malloc( ( total + 1 ) * sizeof(value_element) );
+	csr_neighbors_dir	= malloc( ( total + 1 ) * sizeof(dir_data_t *) );
+	records			= malloc( ( max_degree + 1 ) * sizeof(struct state_element) );
+
+	ASSERT ((records != NULL), ("lunes_compact_topology: malloc error"));
+
+	// Moving the neighbors of each local SE in its slice
+	for ( h = 0; h < stable->count; h++ ) {
+
+		node = stable->list[h];
+		count = 0;
+
+		g_hash_table_iter_init (&iter, node->data->state);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+
+			records[count].key		= *(unsigned int *)key;
+			records[count].elements		= *((value_element *)value);
+			count++;
+		}
+
+		lunes_fill_neighbors (node, records, count, csr_neighbors + offset, csr_neighbors_data + offset, csr_neighbors_dir + offset);
+		node->data->neighbors_owned = NO;
+
+		offset += count;
+
+		// The hash table is not needed anymore
+		g_hash_table_destroy (node->data->state);
+		node->data->state = NULL;
+	}
+
+	free(records);
+
+	topology_compacted = 1;
+}
+
+
+/* -----------------------   GRAPHVIZ DOT FILES SUPPORT --------------------- */
+
+
+/*
+	Support function for the parsing of graphviz dot files,
+	used for loading the graphs (i.e. network topology)
+*/
+void lunes_dot_tokenizer (char *buffer, int *source, int *destination) {
+	char *token;
+	int i = 0;
+
+	
+	token = strtok(buffer, "--");
+	do {
+		i++;
+
+		if ( i == 1 ) {
+
+			*source = atoi(token);
+		}
+
+		if ( i == 2 ) {
+
+			token[strlen(token) - 1] = '\0';
+			*destination = atoi(token);
+		}
+	}
+	while (( token = strtok(NULL, "--") ));
+}
+
+
+/*
+	Adds an edge of the graph to the neighbor table of a local SE, the neighbor
+	will do the same when receiving the "link request" message
+	(unless both the directions are built at load time)
+*/
+static void lunes_add_link (hash_node_t *source_node, int destination) {
+	hash_node_t	*destination_node;
+	value_element	val;
+
+
+	// Is destination vertex a valid simulated entity?
+	if (( destination_node = hash_lookup (table, destination) )) {
+
+		#ifdef AG_DEBUG
+		fprintf(stdout, "%12.2f node: [%5d] adding link to [%5d]\n", simclock, source_node->data->key, destination_node->dir->key);
+		#endif
+
+		// Creating a link between simulated entities (i.e. sending a "link message" between them),
+		// not needed if the LP of the destination builds the reverse direction by itself
+		if ( ! env_local_links )
+			execute_link (simclock + FLIGHT_TIME, source_node, destination_node);
+
+		// Initializing the extra data for the new neighbor
+		val.value = destination;
+
+		// I've to insert the new link (and its extra data) in the neighbor table of this sender,
+		// the receiver will do the same when receiving the "link request" message
+
+		// Adding a new entry in the local state of the sender
+		//	first entry	= key
+		//	second entry	= value
+		//	note: no duplicates are allowed
+		if ( add_entity_state_entry( destination, &val, source_node->data->key, source_node ) == -1) {
+			// Insertion aborted, the key is already in the hash table
+			fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d] key %d (value %d) is a duplicate and can not be inserted in the hash table of local state\n", simclock, source_node->data->key, destination, destination);
+			fflush(stdout);
+			exit(-1);
+		}
+
+	} else {
+		fprintf(stdout, "%12.2f FATAL ERROR, destination: %d does NOT exist!\n", simclock, destination);
+		fflush(stdout);
+		exit(-1);
+	}
+}
+
+
+/*
+	Loading of the graph in binary CSR format (see graph_format.h), the file is
+	mapped in memory and only the rows of the local SEs are accessed.
+	Returns 0 if the binary file is not available
+*/
+static int lunes_load_binary_topology () {
+	char				buffer[1024];
+	int				fd, h;
+	struct stat			info;
+	void				*base;
+	const struct graph_header	*header;
+	const uint64_t			*offsets;
+	const uint32_t			*neighbors;
+	uint64_t			i;
+	unsigned int			vertex;
+	hash_node_t			*node;
+
+
+	// What's the file to read?
+	sprintf(buffer, "%s%s", TESTNAME, TOPOLOGY_GRAPH_BINARY_FILE);
+	if ( ( fd = open(buffer, O_RDONLY) ) < 0 )
+		return(0);
+
+	if ( ( fstat(fd, &info) < 0 ) || ( info.st_size < (off_t) sizeof(struct graph_header) ) ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, the graph file %s is truncated\n", simclock, buffer);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if ( base == MAP_FAILED ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, impossible to map in memory the graph file %s\n", simclock, buffer);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	header = (const struct graph_header *) base;
+
+	if ( ( header->magic != GRAPH_MAGIC ) || ( header->version != GRAPH_VERSION ) ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, the graph file %s has an unsupported format (it has to be created again by dot2csr)\n", simclock, buffer);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	if ( (uint64_t) info.st_size < GRAPH_FILE_SIZE(header->vertices, header->entries, header->relabeled) ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, the graph file %s is truncated\n", simclock, buffer);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	if ( header->vertices > (uint32_t) table->size ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, the graph file %s has %u vertices but only %d SEs are simulated\n", simclock, buffer, header->vertices, table->size);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	// The SEs are assigned to the LPs by ID, a graph partitioned for a different
+	//	number of LPs is still correct but with many remote communications
+	if ( header->parts && ( ( header->parts != (uint32_t) NLP ) || ( header->vertices != (uint32_t) table->size ) ) ) {
+
+		fprintf(stdout, "%12.2f WARNING, the graph file %s has been partitioned for %u LPs and %u SEs (now %d LPs and %d SEs)\n", simclock, buffer, header->parts, header->vertices, NLP, table->size);
+		fflush(stdout);
+	}
+
+	offsets = GRAPH_OFFSETS(base);
+	neighbors = GRAPH_NEIGHBORS(base, header->vertices);
+
+	// The traces have to report the IDs of the original graph definition
+	if ( header->relabeled ) {
+
+		original_ids_count = header->vertices;
+		original_ids = malloc(original_ids_count * sizeof(unsigned int));
+		if ( original_ids == NULL ) {
+
+			fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the original IDs of the graph\n", simclock);
+			fflush(stdout);
+			exit(-1);
+		}
+		memcpy(original_ids, GRAPH_ORIGINAL(base, header->vertices, header->entries), original_ids_count * sizeof(unsigned int));
+	}
+
+	// Only the rows of the local SEs, each edge is stored in both the directions but
+	//	it is added by its endpoint with the lower ID, that sends the "link message"
+	//	(with local links all the row is used and no messages are sent)
+	for ( h = 0; h < stable->count; h++ ) {
+
+		node = stable->list[h];
+		vertex = node->data->key;
+
+		// Isolated vertex
+		if ( vertex >= header->vertices )
+			continue;
+
+		for ( i = offsets[vertex]; i < offsets[vertex + 1]; i++ ) {
+
+			if ( env_local_links || ( neighbors[i] > vertex ) )
+				lunes_add_link (node, neighbors[i]);
+		}
+	}
+
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	// The max degree is precomputed in the graph file
+	if ( env_dissemination_mode == DEGREE_DEPENDENT_GOSSIP )
+		lunes_degdependent_prob_init(header->max_degree);
+	#endif
+
+	munmap(base, info.st_size);
+	close(fd);
+
+	return(1);
+}
+
+
+/*
+	ID of a SE in the original graph definition, used in the traces
+	(it differs from the SE ID only if the graph has been relabeled)
+*/
+unsigned int lunes_original_id (unsigned int key) {
+
+	if ( key < original_ids_count )
+		return(original_ids[key]);
+
+	return(key);
+}
+
+
+/*
+	Opening of the dissemination trace file of this LP, in the format
+	chosen by the TRACE_FORMAT environment variable
+*/
+void lunes_trace_open () {
+
+	char			buffer[1024];
+	struct trace_header	header;
+
+
+	if ( ! env_dissemination_trace )
+		return;
+
+	sprintf(buffer, "%sSIM_TRACE_%03d.%s", TESTNAME, LPID, ( env_trace_format == TRACE_TEXT ) ? "log" : "bin");
+
+	fp_print_trace = fopen(buffer, ( env_trace_format == TRACE_TEXT ) ? "w" : "wb");
+	if ( fp_print_trace == NULL ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, unable to create the trace file %s\n", simclock, buffer);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	// Text traces: a large stdio buffer reduces the number of write syscalls
+	if ( env_trace_format == TRACE_TEXT ) {
+
+		setvbuf(fp_print_trace, NULL, _IOFBF, 1 << 20);
+		return;
+	}
+
+	// Binary traces: the records are collected in blocks and written when the block is full
+	trace_records = (struct trace_record *) malloc (TRACE_BLOCK_RECORDS * sizeof(struct trace_record));
+	if ( env_trace_format == TRACE_BINARY_COMPACT )
+		trace_buffer = (unsigned char *) malloc (TRACE_BLOCK_RECORDS * TRACE_COMPACT_RECORD_MAX_SIZE);
+
+	if ( ( trace_records == NULL ) || ( ( env_trace_format == TRACE_BINARY_COMPACT ) && ( trace_buffer == NULL ) ) ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the trace buffer\n", simclock);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	header.magic	= TRACE_MAGIC;
+	header.version	= TRACE_VERSION;
+	header.lp	= LPID;
+	header.encoding	= env_trace_format;
+	fwrite(&header, sizeof(header), 1, fp_print_trace);
+}
+
+
+/*
+	Writing of the collected records as a new block of the binary trace
+*/
+static void lunes_trace_flush () {
+
+	struct trace_block_header	block;
+
+
+	if ( trace_count == 0 )
+		return;
+
+	block.records = trace_count;
+
+	if ( env_trace_format == TRACE_BINARY_COMPACT ) {
+
+		block.size = trace_encode_block(trace_records, trace_count, trace_buffer);
+		fwrite(&block, sizeof(block), 1, fp_print_trace);
+		fwrite(trace_buffer, 1, block.size, fp_print_trace);
+	} else {
+
+		block.size = trace_count * sizeof(struct trace_record);
+		fwrite(&block, sizeof(block), 1, fp_print_trace);
+		fwrite(trace_records, sizeof(struct trace_record), trace_count, fp_print_trace);
 	}
+
+	trace_count = 0;
+}
+
+
+/*
+	Appending of a record to the current block of the binary trace
+*/
+static inline void lunes_trace_append (unsigned char type, unsigned int node, unsigned int message, unsigned int delay) {
+
+	struct trace_record	*record;
+
+
+	if ( trace_count == TRACE_BLOCK_RECORDS )
+		lunes_trace_flush();
+
+	record = &trace_records[trace_count++];
+	record->node		= node;
+	record->message		= message;
+	record->delay		= ( delay > 0xFFFF ) ? 0xFFFF : delay;	// Saturated, it is a 16 bit field
+	record->type		= type;
+	record->reserved	= 0;
 }
 
 
 /*
-	Dissemination protocol implementation:
-	a new message has been received from a neighbor, it is necessary to forward it in some way
+	Trace: the following records belong to the current timestep,
+	it is used by the analysis tools to process the traces as streams
 */
-void lunes_forward_to_neighbors (hash_node_t *node, long value_to_send, unsigned short ttl, double timestamp, unsigned int creator, unsigned int forwarder) {
+static inline void lunes_trace_timestep () {
 
-	float	threshold;	// Tmp, probabilistic evaluation
+	if ( trace_timestep_valid && ( trace_timestep == (unsigned int) simclock ) )
+		return;
 
+	trace_timestep = (unsigned int) simclock;
+	trace_timestep_valid = 1;
 
-	// Dissemination mode for the forwarded messages
-	switch (env_dissemination_mode) {
+	if ( env_trace_format == TRACE_TEXT )
+		fprintf(fp_print_trace, "T %010u\n", trace_timestep);
+	else
+		lunes_trace_append(TRACE_TIMESTEP, 0, trace_timestep, 0);
+}
 
-		case BROADCAST:			// Probabilistic broadcast
 
-			// Probabilistic evaluation
-			threshold = RND_Interval (S, (double)0, (double)100);
+/*
+	Trace: a new message has been generated by the SE (that has obviously "seen" it)
+*/
+void lunes_trace_generated (unsigned int key, unsigned int message) {
 
-			if ( threshold <= env_broadcast_prob_threshold )
-				lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
-		break;
+	if ( ! env_dissemination_trace )
+		return;
 
-		case GOSSIP_FIXED_PROB:		// Fixed probability dissemination
+	lunes_trace_timestep();
 
-			lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
-		break;
+	if ( env_trace_format == TRACE_TEXT ) {
 
-		#ifdef ADAPTIVE_GOSSIP_SUPPORT
-		case ADAPTIVE_GOSSIP:		// Adaptive dissemination, alg. #1 (adaptive node)
-		case ADAPTIVE_GOSSIP_SENDER:	// Adaptive dissemination, alg. #2 (adaptive sender)
-		case ADAPTIVE_GOSSIP_SPECIFIC:	// Adaptive dissemination, alg. #3 (adaptive specific)
+		fprintf(fp_print_trace, "G %010u\n", message);
+		fprintf(fp_print_trace, "R %010u %010u %010u\n", lunes_original_id(key), message, 0);
+	} else
+		lunes_trace_append(TRACE_GENERATED, lunes_original_id(key), message, 0);
+}
 
-			lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
-		break;
-		#endif
 
-		#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
-		case DEGREE_DEPENDENT_GOSSIP:
+/*
+	Trace: a message has been received by the SE, with the given delay
+*/
+void lunes_trace_received (unsigned int key, unsigned int message, unsigned int delay) {
 
-			lunes_real_forward (node, value_to_send, ttl, timestamp, creator, forwarder);
-		break;
-		#endif
+	if ( ! env_dissemination_trace )
+		return;
 
-		default:
+	lunes_trace_timestep();
 
-			fprintf(stdout, "%12.2f FATAL ERROR, the dissemination mode [%2d] is NOT implemented in this version of LUNES!!!\n", simclock, env_dissemination_mode);
-			fprintf(stdout, "%12.2f NOTE: all the adaptive protocols require compile time support: see the ADAPTIVE_GOSSIP_SUPPORT define in sim-parameters.h\n", simclock);
-			fflush(stdout);
-			exit(-1);
-		break;
-	}
+	if ( env_trace_format == TRACE_TEXT )
+		fprintf(fp_print_trace, "R %010u %010u %03u\n", lunes_original_id(key), message, delay);
+	else
+		lunes_trace_append(TRACE_RECEIVED, lunes_original_id(key), message, delay);
 }
 
 
 /*
-	Dissemination protocol implementation:
-	a new message has been generated in this node and now it is propagated to (some) neighbors
+	Closing of the dissemination trace file, the partial block is written
 */
-void lunes_send_to_neighbors (hash_node_t *node, long value_to_send) {
+void lunes_trace_close () {
 
-	// Iterator to scan the whole state hashtable of neighbors
-	GHashTableIter		iter;
-	gpointer		key, destination;
+	if ( ! env_dissemination_trace )
+		return;
 
-	// All neighbors
-	g_hash_table_iter_init (&iter, node->data->state);
+	if ( env_trace_format != TRACE_TEXT )
+		lunes_trace_flush();
 
-	while (g_hash_table_iter_next (&iter, &key, &destination)) {
+	fclose(fp_print_trace);
 
-		// It's a standard ping message
-		execute_ping (simclock + FLIGHT_TIME, hash_lookup(stable, node->data->key), hash_lookup(table, *(unsigned int *)destination), env_max_ttl, value_to_send, simclock, node->data->key);
-	}
+	free(trace_records);
+	free(trace_buffer);
+	trace_records = NULL;
+	trace_buffer = NULL;
 }
 
 
-#ifdef ADAPTIVE_GOSSIP_SUPPORT
 /*
-	Adaptive sender dissemination (alg. #2) : each node has a single table for increments and 
-	timeouts, this is implemented using the neighbor-based table (of the adaptive specific, alg #3) 
-	and copying the same values to all neighbors of a given node.
-	Note: this task is done at each update!
+	Online metrics: initialization, the SEs are identified by their ID
 */
-void lunes_update_neighbors_table (hash_node_t *node, int cursor, double timeout, float increment) {
+void lunes_metrics_init () {
+
+	metrics_messages = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+	metrics_slots = g_malloc0 (NSIMULATE * NLP * sizeof(unsigned int));
+}
 
-	// Iterator to scan the whole state hashtable of neighbors
-	GHashTableIter		iter;
-	gpointer		key, neighbor;
+
+/*
+	Online metrics: a message that was not in the cache of the SE has been received,
+	the first reception of each message is accounted. The cache is migrated with the
+	SE, the SEs are also tracked in the window of the message because the cached
+	messages can be evicted
+*/
+void lunes_metrics_received (unsigned int key, unsigned int message, float timestamp) {
+
+	MetricsMessage	*received;
+	unsigned int	delay = (unsigned int)(simclock - timestamp);
+	unsigned int	slot, words;
+	uint64_t	bit;
 
 
-	g_hash_table_iter_init (&iter, node->data->state);
+	// The SEs are numbered in the order in which they are found in this LP, the bitsets
+	//	are proportional to the number of local SEs (also the ones that are in the traces)
+	if ( metrics_slots[key] == 0 )
+		metrics_slots[key] = ++metrics_slot_count;
 
-	// Scanning the whole list of neighbor nodes
-	while (g_hash_table_iter_next (&iter, &key, &neighbor)) {
+	slot = metrics_slots[key] - 1;
+	bit = (uint64_t)1 << ( slot & 63 );
+	words = ( metrics_slot_count + 63 ) / 64;
 
-		value_element	*value;
-		unsigned int	keyval;
+	received = g_hash_table_lookup (metrics_messages, GUINT_TO_POINTER(message));
+	if ( received == NULL ) {
 
-		keyval = *(unsigned int *)neighbor;
-		value = (value_element *) g_hash_table_lookup (node->data->state, &keyval);
+		// The message has already been released, it is not possible to know if it is a first reception
+		if ( delay > env_online_metrics_window ) {
 
-		// Updating the table values
-		value->stim_timeout[cursor] = timeout;
-		value->stim_increment[cursor] = increment;
+			metrics_late++;
+			return;
+		}
+
+		received = g_malloc0 (sizeof(MetricsMessage) + words * sizeof(uint64_t));
+		received->birth = timestamp;
+		received->words = words;
+		g_hash_table_insert (metrics_messages, GUINT_TO_POINTER(message), received);
+	} else if ( received->words < words ) {
+
+		// New SEs have been found after the allocation of the bitset
+		g_hash_table_steal (metrics_messages, GUINT_TO_POINTER(message));
+		received = g_realloc (received, sizeof(MetricsMessage) + words * sizeof(uint64_t));
+		memset (&(received->reached[received->words]), 0, ( words - received->words ) * sizeof(uint64_t));
+		received->words = words;
+		g_hash_table_insert (metrics_messages, GUINT_TO_POINTER(message), received);
 	}
+
+	if ( received->reached[slot >> 6] & bit )
+		return;
+
+	received->reached[slot >> 6] |= bit;
+
+	metrics_reached++;
+	metrics_delays += delay;
+	metrics_histogram[ ( delay < METRICS_HISTOGRAM_SIZE ) ? delay : METRICS_HISTOGRAM_SIZE - 1 ]++;
 }
-#endif
 
 
-/* -----------------------   GRAPHVIZ DOT FILES SUPPORT --------------------- */
+/*
+	Online metrics: the message cannot be received anymore
+*/
+static gboolean lunes_metrics_expired (gpointer key, gpointer value, gpointer data) {
+
+	return ( ( ((MetricsMessage *)value)->birth + env_online_metrics_window ) < simclock );
+}
 
 
 /*
-	Support function for the parsing of graphviz dot files,
-	used for loading the graphs (i.e. network topology)
+	Online metrics: the messages that are out of their window are released,
+	it is called at the end of each timestep
 */
-void lunes_dot_tokenizer (char *buffer, int *source, int *destination) {
-	char *token;
-	int i = 0;
+void lunes_metrics_release () {
 
-	
-	token = strtok(buffer, "--");
-	do {
-		i++;
+	g_hash_table_foreach_remove (metrics_messages, lunes_metrics_expired, NULL);
+}
 
-		if ( i == 1 ) {
 
-			*source = atoi(token);
-		}
+/*
+	Online metrics: the counts of this LP are written at shutdown, they are
+	merged with the ones of the other LPs by the performance evaluation scripts
+*/
+void lunes_metrics_write () {
 
-		if ( i == 2 ) {
+	char		buffer[1024];
+	FILE		*fp_print_metrics_trace;
+	unsigned int	h, key;
 
-			token[strlen(token) - 1] = '\0';
-			*destination = atoi(token);
-		}
+
+	sprintf(buffer, "%stracefile-metrics-%d.trace", TESTNAME, LPID);
+
+	fp_print_metrics_trace = fopen(buffer, "w");
+	if ( fp_print_metrics_trace == NULL ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, unable to create the metrics file %s\n", simclock, buffer);
+		fflush(stdout);
+		exit(-1);
 	}
-	while (( token = strtok(NULL, "--") ));
+
+	//	messages generated in this LP, their IDs are dense starting from the first one
+	fprintf(fp_print_metrics_trace, "I %010u\n", MESSAGE_ID(LPID, 0));
+	fprintf(fp_print_metrics_trace, "G %010u\n", lp_message_sequence);
+	//	SEs that have received at least a message in this LP (original graph ID)
+	for ( key = 0; key < NSIMULATE * NLP; key++ ) {
+
+		if ( metrics_slots[key] )
+			fprintf(fp_print_metrics_trace, "N %010u\n", lunes_original_id(key));
+	}
+	//	(message, SE) pairs that have been reached in this LP, sum of their delays
+	fprintf(fp_print_metrics_trace, "R %010lu\n", metrics_reached);
+	fprintf(fp_print_metrics_trace, "S %010lu\n", metrics_delays);
+	//	receptions that have not been accounted (out of the window)
+	fprintf(fp_print_metrics_trace, "L %010lu\n", metrics_late);
+	//	histogram of the delays (non empty buckets)
+	for ( h = 0; h < METRICS_HISTOGRAM_SIZE; h++ ) {
+
+		if ( metrics_histogram[h] )
+			fprintf(fp_print_metrics_trace, "H %03u %010lu\n", h, metrics_histogram[h]);
+	}
+
+	fclose(fp_print_metrics_trace);
+
+	g_hash_table_destroy (metrics_messages);
+	metrics_messages = NULL;
+	g_free (metrics_slots);
+	metrics_slots = NULL;
 }
 
 
 /*
 	Parsing of graphviz dot files,
 	used for loading the graphs (i.e. network topology)
+	Note: if available, the graph in binary format is used
 */
 void lunes_load_graph_topology () { 
 	FILE 		*dot_file;
 	char		buffer[1024];
 	int		source = 0, 
 			destination = 0;
-	hash_node_t	*source_node, 
+	hash_node_t	*source_node,
 			*destination_node;
-	value_element	val;
-	#ifdef ADAPTIVE_GOSSIP_SUPPORT	
-	int		i;
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	unsigned int	*degrees, max_degree = 0;	// Degree of each vertex in the graph
 	#endif
 
 
+	// The binary format does not require any parsing
+	if ( lunes_load_binary_topology() )
+		return;
+
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	degrees = calloc(table->size, sizeof(unsigned int));
+	if ( degrees == NULL ) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, not enough memory to count the degree of vertices\n", simclock);
+		fflush(stdout);
+		exit(-1);
+	}
+	#endif
+
 	// What's the file to read?
 	sprintf(buffer, "%s%s", TESTNAME, TOPOLOGY_GRAPH_FILE);
 	dot_file = fopen(buffer, "r");
@@ -687,53 +1937,37 @@ void lunes_load_graph_topology () {
 		// Parsing line by line
 		lunes_dot_tokenizer(buffer, &source, &destination);
 
+		#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+		// Each edge is defined once in the dot file, all the edges are read
+		//	and therefore also the degree of remote vertices is known
+		if ( ( source >= 0 ) && ( source < table->size ) && ( ++degrees[source] > max_degree ) )
+			max_degree = degrees[source];
+		if ( ( destination >= 0 ) && ( destination < table->size ) && ( ++degrees[destination] > max_degree ) )
+			max_degree = degrees[destination];
+		#endif
+
 		// I check all the edges defined in the dot file to build up "link messages" 
 		// between simulated entities in the simulated network model
 
 		// Is the source node a valid simulated entity?
-		if (( source_node = hash_lookup (stable, source) ))  {
-
-			// Is destination vertex a valid simulated entity?
-			if (( destination_node = hash_lookup (table, destination) )) {
-
-				#ifdef AG_DEBUG
-				fprintf(stdout, "%12.2f node: [%5d] adding link to [%5d]\n", simclock, source_node->data->key, destination_node->data->key);
-				#endif
-
-				// Creating a link between simulated entities (i.e. sending a "link message" between them)
-				execute_link (simclock + FLIGHT_TIME, source_node, destination_node);
-
-				// Initializing the extra data for the new neighbor
-				val.value = destination;
-
-				#ifdef ADAPTIVE_GOSSIP_SUPPORT	
-				for ( i = 0; i < NSIMULATE * NLP; i++)	val.stim_timeout[i] = 0;	// Stimuli timeouts
-				for ( i = 0; i < NSIMULATE * NLP; i++)	val.stim_increment[i] = 0;	// Stimuli values
-				#endif
-
-				// I've to insert the new link (and its extra data) in the neighbor table of this sender,
-				// the receiver will do the same when receiving the "link request" message
-
-				// Adding a new entry in the local state of the sender
-				//	first entry	= key
-				//	second entry	= value
-				//	note: no duplicates are allowed
-				if ( add_entity_state_entry( destination, &val, source, source_node ) == -1) {
-					// Insertion aborted, the key is already in the hash table
-					fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d] key %d (value %d) is a duplicate and can not be inserted in the hash table of local state\n", simclock, source, destination, destination);
-					fflush(stdout);
-					exit(-1);
-				}
+		if (( source_node = hash_lookup (stable, source) ))
+			lunes_add_link (source_node, destination);
 
-			} else {
-				fprintf(stdout, "%12.2f FATAL ERROR, destination: %d does NOT exist!\n", simclock, destination);
-				fflush(stdout);
-				exit(-1);
-			}
-		} 
+		// All the LPs read all the edges, the reverse direction is built by
+		//	the LP of the destination instead of using a "link message"
+		if ( env_local_links && ( destination_node = hash_lookup (stable, destination) ) )
+			lunes_add_link (destination_node, source);
 	}
 
 	fclose(dot_file);
+
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	// The probability of all the degrees in the graph is computed once
+	if ( env_dissemination_mode == DEGREE_DEPENDENT_GOSSIP )
+		lunes_degdependent_prob_init(max_degree);
+
+	free(degrees);
+	#endif
 }
 
 
@@ -757,32 +1991,61 @@ void lunes_user_control_handler (hash_node_t *node) {
 		// Reset of the timer, it is the time of the next sending
 		node->data->s_state.time_of_next_message = simclock + (RND_Exponential(S, 1) * MEAN_NEW_MESSAGE);
 
-		// Creating a (maybe) unique identifier for the new message
-		value = RND_Interval(S, (double) 0, (double)MAXINT);
+		// Creating a unique identifier for the new message
+		if ( lp_message_sequence >= ( 1U << MESSAGE_ID_SEQUENCE_BITS ) ) {
+
+			fprintf(stdout, "%12.2f FATAL ERROR, too many messages generated in this LP, see constant MESSAGE_ID_LP_BITS in file: lunes_constants.h\n", simclock);
+			fflush(stdout);
+			exit(-1);
+		}
+		value = MESSAGE_ID(LPID, lp_message_sequence++);
 
 		// The newly generated message has to be inserted in the local cache
-		lunes_cache_insert(node->data->s_state.cache, value);
+		lunes_cache_insert(&(node->data->s_state.cache), value, simclock, node->data->key);
 
 		// Statistics: print in the trace file all the necessary information
-		//		a new message has been generated
-		#ifdef TRACE_DISSEMINATION
-		fprintf(fp_print_trace, "G %010u\n", value);
-		#endif
-		//		obviously the generating node has "seen" (received) 
-		//		the locally generated message
+		//		a new message has been generated and obviously the
+		//		generating node has "seen" (received) the locally generated message
 		#ifdef TRACE_DISSEMINATION
-		fprintf(fp_print_trace, "R %010u %010u %010u\n", node->data->key, value, 0);
+		lunes_trace_generated(node->data->key, value);
 		#endif
 
+		if ( env_online_metrics )
+			lunes_metrics_received(node->data->key, value, simclock);
+
 		#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 		// Updating (or initializing) the number of my neighbors
-		node->data->num_neighbors = g_hash_table_size(node->data->state);
+		node->data->num_neighbors = node->data->degree;
 		#endif
 
 		// Broadcasting the new message to all neighbors
 		lunes_send_to_neighbors(node, value);
 	}
 
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	// Two-phase gossip, pull phase: periodically the digest of the recently cached
+	// messages is sent to a neighbor chosen at random, that will reply with the
+	// messages missing in the digest
+	if ( ( env_dissemination_mode == TWO_PHASE_GOSSIP ) && ( node->data->s_state.time_of_next_pull <= simclock ) ) {
+
+		CacheElement	*recent[TWO_PHASE_DIGEST_SIZE];
+		unsigned int	ids[TWO_PHASE_DIGEST_SIZE];
+		unsigned int	count, i;
+
+
+		node->data->s_state.time_of_next_pull = simclock + env_pull_period;
+
+		if ( node->data->degree > 0 ) {
+
+			count = lunes_cache_recent (&(node->data->s_state.cache), recent, TWO_PHASE_DIGEST_SIZE);
+			for ( i = 0; i < count; i++ )
+				ids[i] = recent[i]->element;
+
+			execute_digest (simclock + FLIGHT_TIME, node, node->data->neighbors_dir[(unsigned int) RND_Integer(S, (double)1, (double)node->data->degree) - 1], 'D', ids, count);
+		}
+	}
+	#endif
+
 	#ifdef ADAPTIVE_GOSSIP_SUPPORT
 	// Adaptive gossip, all variants (algs. #1, #2, #3)
 	if ( 	( env_dissemination_mode == ADAPTIVE_GOSSIP ) || 
@@ -802,7 +2065,10 @@ void lunes_user_control_handler (hash_node_t *node) {
 			lunes_stimuli(node);
 
 			// Cleanup the local statistics about received messages
-			memset(node->data->s_state.histable, 0, sizeof(node->data->s_state.histable));			
+			g_hash_table_remove_all(node->data->history);
+
+			// The expired stimuli that have not been found yet are removed
+			g_hash_table_foreach_remove(node->data->stimuli, lunes_stimulus_expired, NULL);
 		}
 	}
 	#endif
@@ -815,10 +2081,27 @@ void lunes_user_control_handler (hash_node_t *node) {
 */
 void lunes_user_register_event_handler (hash_node_t *node) {
 
+	// Initialization of the (empty) cache used to suppress duplicate messages
+	lunes_cache_init(&(node->data->s_state.cache));
+
+	// Statistics: duplicate and expired receptions
+	node->data->s_state.duplicates = 0;
+	node->data->s_state.ttl_drops = 0;
+
 	// Initialization of the time for the generation of new messages
 	node->data->s_state.time_of_next_message = simclock + (RND_Exponential(S, 1) * MEAN_NEW_MESSAGE);
 
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	// The first digest is randomized to avoid crowd effects in the system
+	if ( env_dissemination_mode == TWO_PHASE_GOSSIP )
+		node->data->s_state.time_of_next_pull = simclock + RND_Interval (S, (double)0, (double)env_pull_period);
+	#endif
+
 	#ifdef ADAPTIVE_GOSSIP_SUPPORT
+	// Empty history of received messages and no active stimuli
+	lunes_history_init(node);
+	lunes_stimuli_init(node);
+
 	// Adaptive gossip all variants (algs. #1, #2, #3)
 	if ( 	( env_dissemination_mode == ADAPTIVE_GOSSIP ) || 
 		( env_dissemination_mode == ADAPTIVE_GOSSIP_SENDER ) ||
@@ -831,6 +2114,57 @@ void lunes_user_register_event_handler (hash_node_t *node) {
 	#endif
 }
 
+/****************************************************************************
+	LUNES_MIGRATION: a SE has been migrated in this LP, LUNES has to rebuild
+		its table of neighbors using the records in the migration message
+*/
+void lunes_user_migration_event_handler (hash_node_t *node, int id, Msg *msg) {
+
+	int		tmp;
+	unsigned int	count = msg->migr.migration_static.dyn_records;
+
+
+	#ifdef ADAPTIVE_GOSSIP_SUPPORT
+	// The history of received messages is not migrated, a whole evaluation period
+	//	is needed before the next evaluation
+	lunes_history_init(node);
+	node->data->s_state.histable_cleanup = simclock + ADAPTIVE_GOSSIP_EVALUATION_PERIOD;
+
+	// The active stimuli are packed just after the records of neighbors
+	lunes_stimuli_init(node);
+	lunes_stimuli_unpack(node, (const unsigned char *) &(msg->migr.migration_dynamic.records[count]), msg->migr.migration_static.stim_records);
+	#endif
+
+	if ( topology_compacted ) {
+
+		// The topology is already built: the SE gets its own compact table
+		node->data->neighbors_owned = YES;
+
+		lunes_fill_neighbors (node, msg->migr.migration_dynamic.records, count,
+			malloc( ( count + 1 ) * sizeof(unsigned int) ), malloc( ( count + 1 ) * sizeof(value_element) ), malloc( ( count + 1 ) * sizeof(dir_data_t *) ) );
+	} else {
+
+		// The topology is still under construction: the hash table is used
+		node->data->state = g_hash_table_new_full(g_int_hash, g_int_equal, g_free, NULL);
+
+		for ( tmp = 0; tmp < count; tmp++ ) {
+
+			// Adding a new entry in the local state of the migrated node (rebuilds its local state)
+			//	first entry	= key
+			//	second entry	= value
+			//	note: no duplicates are allowed
+			if ( add_entity_state_entry( msg->migr.migration_dynamic.records[tmp].key, 
+				&(msg->migr.migration_dynamic.records[tmp].elements), id, node ) == -1 ) {
+
+				// Insertion aborted, the key is already in the hash table
+				fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d] key %d (value %d) is a duplicate and can not be inserted in the hash table of local state\n", simclock, id, msg->migr.migration_dynamic.records[tmp].key, msg->migr.migration_dynamic.records[tmp].elements.value);
+				fflush(stdout);
+				exit(-1);
+			}
+		}
+	}
+}
+
 
 #ifdef ADAPTIVE_GOSSIP_SUPPORT
 /****************************************************************************
@@ -839,11 +2173,11 @@ void lunes_user_register_event_handler (hash_node_t *node) {
 */
 void	lunes_user_stimulus_event_handler (hash_node_t *node, int from, Msg *msg) {
 
-	unsigned int	key;			// Key to access the hashtable
-	value_element	*value;			// Extra data associated to the key
+	StimulusElement	*stimulus;		// Stimulus associated to the neighbor
 
 	int		missing_sender;		// Node that has sent the stimulus
 	int		cursor;
+	int		neighbor;
 
 
 	// Why this stimulus has been sent? Some node is receiving less messages 
@@ -854,12 +2188,8 @@ void	lunes_user_stimulus_event_handler (hash_node_t *node, int from, Msg *msg) {
 	fprintf(stdout, "%12.2f node: [%5d] received a stimulus message from agent [%5d], missing sender [%5d]\n", simclock, node->data->key, from, missing_sender);
 	#endif
 
-	// I've to access the information about the neighbor that has sent the stimulus
-	key = from;
-	value = (value_element *) g_hash_table_lookup (node->data->state, &key);
-
-	// Validity check
-	if (value == NULL) {
+	// Validity check, the stimulus has to be sent by a neighbor
+	if ( lunes_neighbor_lookup (node, from) == NULL ) {
 		fprintf(stdout, "%12.2f node: FATAL ERROR, node [%5d] has received a stimulus from node [%5d], thas it NOT a neighbor\n", simclock, node->data->key, from);
 		fflush(stdout);
 		exit(-1);
@@ -871,16 +2201,23 @@ void	lunes_user_stimulus_event_handler (hash_node_t *node, int from, Msg *msg) {
 		cursor = 0;
 	else	cursor = missing_sender;
 
+	// In the "adaptive sender" dissemination (alg. #2) each node has a single table that is used for 
+	// the dissemination probabilites of each sender, it is shared by all neighbors
+	if ( env_dissemination_mode == ADAPTIVE_GOSSIP_SENDER )
+		neighbor = 0;
+	else	neighbor = from;
+
 	// There is no valid stimulus active: the period in which the stimulus was active is finished 
 	//	or there has been no stimuli up to now
-	if ( ( value->stim_timeout[cursor] <= simclock ) || ( value->stim_timeout[cursor] == 0 ) ) {
+	if ( ( stimulus = lunes_stimulus_lookup (node, neighbor, cursor) ) == NULL ) {
 
 		// Updating the stimulus probability and its timeout
-		value->stim_increment[cursor] = STIMULUS_PROBABILITY_INCREMENT;
-		value->stim_timeout[cursor] = simclock + STIMULUS_LENGTH;
+		stimulus = lunes_stimulus_insert (node, neighbor, cursor);
+		stimulus->increment = STIMULUS_PROBABILITY_INCREMENT;
+		stimulus->timeout = simclock + STIMULUS_LENGTH;
 
 		#ifdef AG_DEBUG
-		fprintf(stdout, "%12.2f node: [%5d] stimulus to neighbor [%5d] will be %3.2f with timeout %12.2f\n", simclock, node->data->key, from, value->stim_increment[cursor], value->stim_timeout[cursor]);
+		fprintf(stdout, "%12.2f node: [%5d] stimulus to neighbor [%5d] will be %3.2f with timeout %12.2f\n", simclock, node->data->key, from, stimulus->increment, stimulus->timeout);
 		#endif
 
 	} else {
@@ -890,7 +2227,7 @@ void	lunes_user_stimulus_event_handler (hash_node_t *node, int from, Msg *msg) {
 		float	residual_stimulus;
 
 		// First of all it is necessary to calculate how much is the stimulus residual
-		residual_window = (int) ( value->stim_timeout[cursor] - simclock ); 
+		residual_window = (int) ( stimulus->timeout - simclock ); 
 		residual_stimulus = ( STIMULUS_PROBABILITY_INCREMENT * residual_window ) / STIMULUS_LENGTH;
 
 		#ifdef AG_DEBUG
@@ -898,24 +2235,18 @@ void	lunes_user_stimulus_event_handler (hash_node_t *node, int from, Msg *msg) {
 		#endif
 
 		// The new stimulus is added to the residual stimulus
-		value->stim_increment[cursor] = STIMULUS_PROBABILITY_INCREMENT + residual_stimulus;
+		stimulus->increment = STIMULUS_PROBABILITY_INCREMENT + residual_stimulus;
 
 		// Validity check: the combined stimulus can not be larger than 100%
-		if  ( ( env_fixed_prob_threshold + value->stim_increment[cursor] ) > 100 )
-			value->stim_increment[cursor] = 100 - env_fixed_prob_threshold;
+		if  ( ( env_fixed_prob_threshold + stimulus->increment ) > 100 )
+			stimulus->increment = 100 - env_fixed_prob_threshold;
 
 		// There's also a new timeout
-		value->stim_timeout[cursor] = simclock + STIMULUS_LENGTH;
+		stimulus->timeout = simclock + STIMULUS_LENGTH;
 
 		#ifdef AG_DEBUG
-		fprintf(stdout, "%12.2f node: [%5d] composed stimulus to neighbor [%5d] will be %3.2f with timeout %12.2f\n", simclock, node->data->key, from, value->stim_increment[cursor], value->stim_timeout[cursor]);
+		fprintf(stdout, "%12.2f node: [%5d] composed stimulus to neighbor [%5d] will be %3.2f with timeout %12.2f\n", simclock, node->data->key, from, stimulus->increment, stimulus->timeout);
 		#endif
-
-		// In the "adaptive sender" dissemintaion (alg. #2) each node has a single table that is used for 
-		// the dissemination probabilites of each sender. This is implemented using the table of 
-		// "adaptive specific" alg and updating the values associated to all neighbors
-		if ( env_dissemination_mode == ADAPTIVE_GOSSIP_SENDER )
-			lunes_update_neighbors_table (node, cursor, value->stim_timeout[cursor], value->stim_increment[cursor]);
 	}
 }
 #endif
@@ -923,11 +2254,15 @@ void	lunes_user_stimulus_event_handler (hash_node_t *node, int from, Msg *msg) {
 
 /****************************************************************************
 	LUNES_PING: what happens in LUNES when a node receives a PING message?
+		Boolean, the message was not in the cache of the node (i.e. it
+		is the first reception, unless the message has been evicted)
 */
-void	lunes_user_ping_event_handler (hash_node_t *node, int forwarder, Msg *msg) {
+int	lunes_user_ping_event_handler (hash_node_t *node, int forwarder, Msg *msg) {
+
+	int		first = 0;
 
 	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
-	gpointer neighbor;
+	value_element	*neighbor;
 	#endif
 
 	#ifdef ADAPTIVE_GOSSIP_SUPPORT
@@ -947,7 +2282,23 @@ void	lunes_user_ping_event_handler (hash_node_t *node, int forwarder, Msg *msg)
 	// Time-To-Live check
 	if (msg->ping.ping_static.ttl == 0 ) {
 
-		// It's time to drop the message
+		// The message is not forwarded. When only the first receptions are traced (or
+		//	accounted by the online metrics) it is cached, the node can be reached
+		//	only by expired messages and their later copies are duplicates. Otherwise
+		//	the cache is not modified, as in the standard dissemination
+		if ( lunes_cache_find ( &(node->data->s_state.cache), msg->ping.ping_static.msgvalue ) == 0 ) {
+
+			// It's time to drop the message
+			first = 1;
+			node->data->s_state.ttl_drops++;
+
+			if ( env_trace_first_receptions || env_online_metrics )
+				lunes_cache_insert (&(node->data->s_state.cache), msg->ping.ping_static.msgvalue, msg->ping.ping_static.timestamp, msg->ping.ping_static.creator);
+		} else {
+
+			// The message is already in the cache
+			node->data->s_state.duplicates++;
+		}
 
 		#ifdef TTLDEBUG
 		fprintf(stdout, "%12.2f node: [%5d] message [%5d] TTL=0, dropping\n", simclock, node->data->key, msg->ping.ping_static.msgvalue);
@@ -957,18 +2308,19 @@ void	lunes_user_ping_event_handler (hash_node_t *node, int forwarder, Msg *msg)
 		// The TTL is still OK
 
 		// Verifies (using the local cache) if the message has been already received
-		if ( lunes_cache_verify ( node->data->s_state.cache, msg->ping.ping_static.msgvalue ) == 0 )  {
+		if ( lunes_cache_verify ( &(node->data->s_state.cache), msg->ping.ping_static.msgvalue ) == 0 )  {
 
 			// It has not been received
-			lunes_cache_insert (node->data->s_state.cache, msg->ping.ping_static.msgvalue);
+			first = 1;
+			lunes_cache_insert (&(node->data->s_state.cache), msg->ping.ping_static.msgvalue, msg->ping.ping_static.timestamp, msg->ping.ping_static.creator);
 
 			#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 			// Updating (or initializing) the number of my neighbors
-			node->data->num_neighbors = g_hash_table_size(node->data->state);
+			node->data->num_neighbors = node->data->degree;
 
 			// Updating the number of neighbors of forwarder's neighbors
-			neighbor = g_hash_table_lookup (node->data->state, &forwarder);
-			((value_element *)neighbor)->num_neighbors = msg->ping.ping_static.num_neighbors;
+			if (( neighbor = lunes_neighbor_lookup (node, forwarder) ))
+				neighbor->num_neighbors = msg->ping.ping_static.num_neighbors;
 			#endif
 
 			// Dissemination (to some of) the neighbors
@@ -977,11 +2329,152 @@ void	lunes_user_ping_event_handler (hash_node_t *node, int forwarder, Msg *msg)
 		} else {
 
 			// The message is already in the cache -> it is dropped
+			node->data->s_state.duplicates++;
 
 			#ifdef CACHEDEBUG
 			fprintf(stdout, "%12.2f node: [%5d] message [%5d] is already in cache, dropping\n", simclock, node->data->key, msg->ping.ping_static.msgvalue);
 			#endif
 		}
 	}
+
+	return(first);
+}
+
+
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+/*
+	Two-phase gossip: the neighbor that has sent a message of the pull phase,
+	NULL if the sender is not a neighbor of the node
+*/
+static dir_data_t *lunes_pull_peer (hash_node_t *node, int from) {
+
+	value_element	*neighbor;
+
+
+	// Only the neighbors take part in the pull phase
+	if ( ( neighbor = lunes_neighbor_lookup (node, from) ) == NULL )
+		return(NULL);
+
+	return(node->data->neighbors_dir[neighbor - node->data->neighbors_data]);
+}
+
+
+/*
+	Two-phase gossip: Boolean, the cached message would be older than the max
+	age of the pulled messages when received after the given number of hops
+*/
+static int lunes_pull_too_old (CacheElement *cached, unsigned int hops) {
+
+	return ( ( simclock + ( hops * FLIGHT_TIME ) - cached->timestamp ) > env_pull_max_age );
+}
+
+
+/****************************************************************************
+	LUNES_DIGEST: a neighbor has sent the digest of its recently cached messages,
+		the IDs of the recently cached messages of this node that are missing
+		in the digest are offered to the neighbor (pull phase of the two-phase gossip)
+*/
+void	lunes_user_digest_event_handler (hash_node_t *node, int from, unsigned int *ids, unsigned int count) {
+
+	CacheElement	*recent[TWO_PHASE_DIGEST_SIZE];
+	unsigned int	offer[TWO_PHASE_DIGEST_SIZE];
+	unsigned int	recent_count, offered = 0, i;
+	dir_data_t	*receiver;
+
+
+	if ( ( receiver = lunes_pull_peer (node, from) ) == NULL )
+		return;
+
+	// The digest is sorted to look for the cached messages with a binary search
+	qsort (ids, count, sizeof(unsigned int), lunes_digest_compare);
+
+	recent_count = lunes_cache_recent (&(node->data->s_state.cache), recent, TWO_PHASE_DIGEST_SIZE);
+
+	// The messages that would be received after their max age (offer, request and pulled message) are not offered
+	for ( i = 0; i < recent_count; i++ ) {
+
+		if ( lunes_pull_too_old (recent[i], 3) )
+			continue;
+
+		if ( bsearch (&(recent[i]->element), ids, count, sizeof(unsigned int), lunes_digest_compare) == NULL )
+			offer[offered++] = recent[i]->element;
+	}
+
+	if ( offered > 0 )
+		execute_digest (simclock + FLIGHT_TIME, node, receiver, 'O', offer, offered);
+}
+
+
+/****************************************************************************
+	LUNES_OFFER: the neighbor that has received the digest of this node has
+		offered some messages, the ones that are not in the whole cache of
+		this node are requested (pull phase of the two-phase gossip)
+*/
+void	lunes_user_offer_event_handler (hash_node_t *node, int from, unsigned int *ids, unsigned int count) {
+
+	unsigned int	request[TWO_PHASE_DIGEST_SIZE];
+	unsigned int	requested = 0, i;
+	dir_data_t	*receiver;
+
+
+	if ( ( receiver = lunes_pull_peer (node, from) ) == NULL )
+		return;
+
+	// The digest contains only the most recent messages, the older ones can still be cached
+	for ( i = 0; i < count; i++ ) {
+
+		if ( lunes_cache_find (&(node->data->s_state.cache), ids[i]) == 0 )
+			request[requested++] = ids[i];
+	}
+
+	if ( requested > 0 )
+		execute_digest (simclock + FLIGHT_TIME, node, receiver, 'Q', request, requested);
+}
+
+
+/****************************************************************************
+	LUNES_REQUEST: a neighbor has requested some of the offered messages,
+		the ones that are still cached are sent back (pull phase of the two-phase gossip)
+*/
+void	lunes_user_request_event_handler (hash_node_t *node, int from, unsigned int *ids, unsigned int count) {
+
+	CacheElement	*cached;
+	unsigned int	found, i;
+	dir_data_t	*receiver;
+
+
+	if ( ( receiver = lunes_pull_peer (node, from) ) == NULL )
+		return;
+
+	for ( i = 0; i < count; i++ ) {
+
+		if ( ( found = lunes_cache_find (&(node->data->s_state.cache), ids[i]) ) == 0 )
+			continue;
+
+		cached = &(node->data->s_state.cache.slots[found - 1]);
+		if ( lunes_pull_too_old (cached, 1) )
+			continue;
+
+		execute_pulled (simclock + FLIGHT_TIME, node, receiver, cached->element, cached->timestamp, cached->creator);
+	}
 }
 
+
+/****************************************************************************
+	LUNES_PULLED: a message missing in the digest of this node has been received,
+		it is cached but not forwarded (pull phase of the two-phase gossip),
+		Boolean, the message was not in the cache of the node
+*/
+int	lunes_user_pulled_event_handler (hash_node_t *node, int forwarder, Msg *msg) {
+
+	// The same message can be pulled from more neighbors or received in the push phase
+	if ( lunes_cache_verify ( &(node->data->s_state.cache), msg->ping.ping_static.msgvalue ) == 0 ) {
+
+		lunes_cache_insert (&(node->data->s_state.cache), msg->ping.ping_static.msgvalue, msg->ping.ping_static.timestamp, msg->ping.ping_static.creator);
+		return(1);
+	}
+
+	node->data->s_state.duplicates++;
+	return(0);
+}
+#endif
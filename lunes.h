@@ -16,15 +16,36 @@
 #include "utils.h"
 
 // LUNES handlers
-void	lunes_user_ping_event_handler ( hash_node_t *, int, Msg * );
+int	lunes_user_ping_event_handler ( hash_node_t *, int, Msg * );
 void	lunes_user_register_event_handler ( hash_node_t * );
 void	lunes_user_control_handler ( hash_node_t * );
+void	lunes_user_migration_event_handler ( hash_node_t *, int, Msg * );
 #ifdef ADAPTIVE_GOSSIP_SUPPORT
 void	lunes_user_stimulus_event_handler ( hash_node_t *, int, Msg * );
 #endif
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+void	lunes_user_digest_event_handler ( hash_node_t *, int, unsigned int *, unsigned int );
+void	lunes_user_offer_event_handler ( hash_node_t *, int, unsigned int *, unsigned int );
+void	lunes_user_request_event_handler ( hash_node_t *, int, unsigned int *, unsigned int );
+int	lunes_user_pulled_event_handler ( hash_node_t *, int, Msg * );
+#endif
 
 // Support functions
 void 	lunes_load_graph_topology ();
+void	lunes_compact_topology ();
+value_element *	lunes_neighbor_lookup ( hash_node_t *, unsigned int );
+unsigned int	lunes_original_id ( unsigned int );
+void	lunes_trace_open ();
+void	lunes_trace_generated ( unsigned int, unsigned int );
+void	lunes_trace_received ( unsigned int, unsigned int, unsigned int );
+void	lunes_trace_close ();
+void	lunes_metrics_init ();
+void	lunes_metrics_received ( unsigned int, unsigned int, float );
+void	lunes_metrics_release ();
+void	lunes_metrics_write ();
+#ifdef ADAPTIVE_GOSSIP_SUPPORT
+unsigned int	lunes_stimuli_pack ( hash_node_t *, unsigned char *, unsigned int );
+#endif
 
 #endif /* __LUNES_H */
 
@@ -15,10 +15,27 @@
 
 // 	General parameters
 #define TOPOLOGY_GRAPH_FILE 			"test-graph-cleaned.dot"	// Graph definition to be used for network construction
+#define TOPOLOGY_GRAPH_BINARY_FILE		"test-graph.csr"		// Graph definition in binary format (see dot2csr), used if present
 #define MAX_CACHE_SIZE				512				// MAX cache size (in each node)
+#define CACHE_INDEX_BITS			10				// Size (log2) of the cache index, it must be at least 2 * MAX_CACHE_SIZE
+#define CACHE_INDEX_SIZE			(1 << CACHE_INDEX_BITS)
+#if CACHE_INDEX_SIZE < 2 * MAX_CACHE_SIZE
+#error "CACHE_INDEX_BITS is too small for MAX_CACHE_SIZE, the cache index must have at least 2 * MAX_CACHE_SIZE buckets"
+#endif
+#if CACHE_INDEX_SIZE > 65535
+#error "CACHE_INDEX_BITS is too large, the cache slots are linked with 16 bit positions"
+#endif
 #define MAX_TTL					10				// TTL of new messages, standard value
 #define	MEAN_NEW_MESSAGE 			30				// Generation of new messages: exponential distribution, mean value
 
+//	Message identifiers: the LP that generates the message (high bits) and a sequence number in that LP,
+//	the IDs are unique and the messages generated by each LP are numbered from 0 (dense)
+#define MESSAGE_ID_LP_BITS			8				// Max number of LPs is 2^MESSAGE_ID_LP_BITS
+#define MESSAGE_ID_SEQUENCE_BITS		(32 - MESSAGE_ID_LP_BITS)	// Max number of messages generated in each LP is 2^MESSAGE_ID_SEQUENCE_BITS
+#define MESSAGE_ID(lp, sequence)		(((unsigned int)(lp) << MESSAGE_ID_SEQUENCE_BITS) | (unsigned int)(sequence))
+#define MESSAGE_ID_LP(id)			((unsigned int)(id) >> MESSAGE_ID_SEQUENCE_BITS)
+#define MESSAGE_ID_SEQUENCE(id)			((unsigned int)(id) & ((1U << MESSAGE_ID_SEQUENCE_BITS) - 1))
+
 #ifdef ADAPTIVE_GOSSIP_SUPPORT
 //	Adaptive dissemination algorithms
 #define ADAPTIVE_GOSSIP_EVALUATION_PERIOD	50				// Length of the evaluation period
@@ -26,10 +43,19 @@
 #define	STIMULUS_LENGTH				200				// Length of each stimulus
 #endif
 
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+//	Two-phase gossip
+#define TWO_PHASE_DIGEST_SIZE			64				// Max number of message IDs in a digest (pull phase)
+#define TWO_PHASE_MAX_AGE			254				// Max age of the pulled messages, the analysis tools support delays up to 254 timesteps
+#endif
+
+//	Online metrics
+#define METRICS_HISTOGRAM_SIZE			256				// Delays histogram: number of buckets (the last one is for longer delays)
+
 //	Dissemination protocols
 #define	BROADCAST			0	// Probabilistic broadcast
 #define	GOSSIP_FIXED_PROB		1	// Fixed probability
-#define GOSSIP_FIXED_FANOUT		2	// Fixed fanout (NOT IMPLEMENTED IN THIS VERSION)
+#define GOSSIP_FIXED_FANOUT		2	// Fixed fanout
 #define UP_AND_DOWN			3	// Up and Down dissemination (NOT IMPLEMENTED IN THIS VERSION)
 //
 #ifdef ADAPTIVE_GOSSIP_SUPPORT
@@ -41,6 +67,10 @@
 #ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 #define DEGREE_DEPENDENT_GOSSIP		7	// Degree Dependent Gossip
 #endif
+//
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+#define TWO_PHASE_GOSSIP		8	// Two-phase gossip: fixed probability push and digest-based pull
+#endif
 
 #endif /* __LUNES_CONSTANTS_H */
 
@@ -107,6 +107,7 @@
 #include <gaia.h>
 #include "utils.h"
 #include "user_event_handlers.h"
+#include "lunes.h"
 
 
 /*-------------------------- D E B U G --------------------------------------*/
@@ -157,7 +158,20 @@ float		env_end_clock = END_CLOCK;		// End clock (simulated time)
 unsigned short	env_dissemination_mode;			// Dissemination mode
 float		env_broadcast_prob_threshold;		// Dissemination: conditional broadcast, probability threshold
 unsigned int	env_cache_size;				// Cache size of each node
+unsigned int	env_ping_bundling = 0;			// Pings directed to the same remote LP are bundled
+unsigned int	env_local_links = 0;			// Both the directions of each edge are built at load time
+unsigned int	env_trace_format = 0;			// Format of the dissemination trace files (see trace_format.h)
+unsigned int	env_trace_first_receptions = 0;		// Only the first receptions are traced
+unsigned int	env_dissemination_trace = 1;		// The dissemination trace files are written
+unsigned int	env_online_metrics = 0;			// Coverage and delay are computed during the run
+unsigned int	env_online_metrics_window = 0;		// Online metrics: timesteps in which a message can be received
 float		env_fixed_prob_threshold;		// Dissemination: fixed probability, probability threshold
+unsigned int	env_fixed_prob_skip_sampling = 0;	// Dissemination: fixed probability, geometric skip sampling
+unsigned int	env_fanout;				// Dissemination: fixed fanout, number of neighbors
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+float		env_pull_period;			// Dissemination: two-phase gossip, timesteps between two digests
+unsigned int	env_pull_max_age;			// Dissemination: two-phase gossip, max age of the pulled messages
+#endif
 #ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 unsigned int    env_probability_function;   		// Probability function for Degree Dependent Gossip
 double          env_function_coefficient;   		// Coefficient of the probability function
@@ -168,7 +182,7 @@ double          env_function_coefficient;   		// Coefficient of the probability
 /* 			            Hash Tables		      	            */
 /* ************************************************************************ */
 
-hash_t		hash_table,  *table=&hash_table;		/* Global hash table, contains ALL the simulated entities */
+hash_t		hash_table,  *table=&hash_table;		/* Global hash table, contains the directory records of ALL the simulated entities */
 hash_t		sim_table,   *stable=&sim_table;		/* Local hash table, contains only the locally managed entities */
 /*---------------------------------------------------------------------------*/
 
@@ -270,22 +284,30 @@ static int UNUSED ScanMigrating () {
 
                 // Dynamic part of the agents state
                 //
-		// The hashtable is empty
+		// The topology has been already compacted, the neighbors are in the compact table
 		if ( se->data->state == NULL ) {
 			
 			#ifdef DEBUG
-			fprintf(stdout, "ID: %d is empty\n", se->data->key);
+			fprintf(stdout, "ID: %d uses the compact table of neighbors\n", se->data->key);
 			fflush(stdout);
 			#endif	
 
-			// No dynamic part in the migration message
-			m.migration_static.dyn_records = 0;
+			// One record for each neighbor
+			m.migration_static.dyn_records = se->data->degree;
 		} else {
 			// The state of the SE has to be inserted in the migration message as a set of records
 			//	number of records in the dynamic part of the migration message
 			m.migration_static.dyn_records = g_hash_table_size(se->data->state);
 		}
 
+		if ( m.migration_static.dyn_records > MAX_MIGRATION_DYNAMIC_RECORDS ) {
+
+			// The state of the SE does not fit in the dynamic part of the migration message
+			fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d] the state of the migrating node has %d records, see constant MAX_MIGRATION_DYNAMIC_RECORDS (%d) in file: sim-parameters.h\n", simclock, se->data->key, m.migration_static.dyn_records, MAX_MIGRATION_DYNAMIC_RECORDS);
+			fflush(stdout);
+			exit(-1);
+		}
+
 		// Copying the local state of the migrating entity in the payload of the migration message
 		//	for each record in the entity state a new record is appended in the dynamic part
 		//	of the migration message
@@ -313,6 +335,13 @@ static int UNUSED ScanMigrating () {
 
 				state_position++;
 			}
+		} else {
+
+			for ( state_position = 0; state_position < se->data->degree; state_position++ ) {
+
+				m.migration_dynamic.records[state_position].key =		se->data->neighbors[state_position];
+				m.migration_dynamic.records[state_position].elements = 		se->data->neighbors_data[state_position];
+			}
 		}
 
 		// It is time to clean up the hash table of the migrated node
@@ -322,8 +351,30 @@ static int UNUSED ScanMigrating () {
 			g_hash_table_destroy (se->data->state);
 		}
 
+		#ifdef ADAPTIVE_GOSSIP_SUPPORT
+		// The active stimuli are packed just after the records of the dynamic part
+		m.migration_static.stim_records = lunes_stimuli_pack (se, (unsigned char *) &(m.migration_dynamic.records[m.migration_static.dyn_records]),
+			( m.migration_static.dyn_records < MAX_MIGRATION_DYNAMIC_RECORDS ) ?
+			( ( MAX_MIGRATION_DYNAMIC_RECORDS - m.migration_static.dyn_records ) * sizeof( struct state_element ) ) / sizeof( StimulusElement ) : 0 );
+
+		// The history of received events is not migrated
+		if ( se->data->history != NULL )	g_hash_table_destroy (se->data->history);
+		if ( se->data->stimuli != NULL )	g_hash_table_destroy (se->data->stimuli);
+		#endif
+
+		// The compact table of neighbors is freed only if it is not a slice of the LP-wide one
+		if ( se->data->neighbors_owned == YES ) {
+
+			free (se->data->neighbors);
+			free (se->data->neighbors_data);
+			free (se->data->neighbors_dir);
+		}
+
 		// Calculating the real size of the migration message
 		message_size = sizeof( struct _migration_static_part ) + ( m.migration_static.dyn_records * sizeof( struct state_element ) );
+		#ifdef ADAPTIVE_GOSSIP_SUPPORT
+		message_size += m.migration_static.stim_records * sizeof( StimulusElement );
+		#endif
 
 		if ( message_size >= BUFFER_SIZE ) {
 
@@ -336,8 +387,9 @@ static int UNUSED ScanMigrating () {
 		// The migration is really executed
 		GAIA_Migrate ( se->data->key, (void *)&m, message_size );
 
-		// Removing the migrated SE from the local list of migrating nodes
-		hash_delete( LSE, stable, se->data->key );
+		// Removing the migrated SE from the local list of migrating nodes,
+		//	its state is freed (the directory record is kept)
+		hash_delete( LSE, stable, se->dir->key );
 	}
 
 	// Returning the number of migrated SE (for statistics)
@@ -378,31 +430,31 @@ struct hash_node_t*	validation_model_events (int id, int to, Msg *msg) {
 */
 static void	register_event_handler (int id, int lp) {
 
- 	hash_node_t 		*node;
+ 	hash_node_t 		*node, *local_node;
 	
 
 	// In every case the new node has to be inserted in the global hash table
-	//	containing all the Simulated Entities
+	//	containing all the Simulated Entities (only its directory record)
 	node = hash_insert ( GSE, table, NULL, id, lp );
 	
 	if ( node ) {
 
-		node->data->s_state.changed = YES;
+		node->dir->changed = YES;
 
 		// If the SMH is local then it has to be inserted also in the local
 		//	hashtable and some extra management is required				
 		if ( lp == LPID ) {
 
-			// Call the appropriate user event handler
-			user_register_event_handler( node, id );
-
-			// Inserting it in the table of local SEs
-			if ( ! hash_insert( LSE, stable, node->data, node->data->key, LPID ) ) {
+			// Inserting it in the table of local SEs, its state is allocated only here
+			if ( ! ( local_node = hash_insert( LSE, stable, node->dir, node->dir->key, LPID ) ) ) {
 				// Unable to allocate memory for local SEs 
 				fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d] impossible to add new elements to the hash table of local entities\n", simclock, id);
 				fflush(stdout);
 				exit(-1);
 			}
+
+			// Call the appropriate user event handler
+			user_register_event_handler( local_node, id );
 		}
 	}
 	else {
@@ -418,7 +470,7 @@ static void	register_event_handler (int id, int lp) {
 */
 static void	notify_migration_event_handler (int id, int to) {
 
-	hash_node_t *node;
+	hash_node_t *node, *local_node;
 
 
 	#ifdef DEBUG
@@ -428,12 +480,12 @@ static void	notify_migration_event_handler (int id, int to) {
 	// The GAIA framework has decided that a local SE has to be migrated,
 	//	the migration can NOT be executed immediately because the SE
 	//	could be the destination of some "in flight" messages
-	if ( ( node = hash_lookup ( table, id ) ) )  {
+	if ( ( node = hash_lookup ( table, id ) ) && ( local_node = hash_lookup ( stable, id ) ) )  {
 		/* Now it is updated the list of SEs that are enabled to migrate (flagged) */
-		list_add ( mlist, node );
+		list_add ( mlist, local_node );
 
-		node->data->lp			= to;
-		node->data->s_state.changed	= YES;
+		node->dir->lp			= to;
+		node->dir->changed		= YES;
 
 		// Call the appropriate user event handler
 		user_notify_migration_event_handler ();
@@ -457,8 +509,8 @@ static void	notify_ext_migration_event_handler (int id, int to) {
 	//	the simulation. In some special cases the local LP has to take care of 
 	//	this information 
 	if ( ( node = hash_lookup ( table, id ) ) )  {
-		node->data->lp			= to;		// Destination LP of the migration
-		node->data->s_state.changed	= YES;
+		node->dir->lp			= to;		// Destination LP of the migration
+		node->dir->changed		= YES;
 
 		// Call the appropriate user event handler
 		user_notify_ext_migration_event_handler ();
@@ -492,8 +544,8 @@ static void	migration_event_handler (int id, Msg *msg) {
 	#endif
 
 	if ( ( node = hash_lookup ( table, id ) ) ) {
-		// Inserting the new SE in the local table
-		hash_insert(LSE, stable, node->data, node->data->key, LPID);
+		// Inserting the new SE in the local table, its state is allocated here
+		node = hash_insert(LSE, stable, node->dir, node->dir->key, LPID);
 
 		// Call the appropriate user event handler
 		user_migration_event_handler(node, id, msg);
@@ -629,8 +681,8 @@ int main(int argc, char* argv[]) {
 	lcr_fp = fopen(dat_filename, "w");
 	
 	// Data structures initialization (hash tables and migration list)
-	hash_init ( table,  NSIMULATE * NLP );		// Global hashtable: all the SEs
-	hash_init ( stable, NSIMULATE );		// Local hastable: local SEs
+	hash_init ( GSE, table,  NSIMULATE * NLP );	// Global hashtable: all the SEs
+	hash_init ( LSE, stable, NSIMULATE * NLP );	// Local hastable: local SEs (any SE can be migrated here)
 	list_init (mlist);				// Migration list (pending migrations in the local LP)
 
 	// Starting the execution timer
@@ -732,6 +784,10 @@ int main(int argc, char* argv[]) {
 						Generate_Computation_and_Interactions( NSIMULATE * NLP );
 					}
 
+					// The model level messages that are still pending (e.g. bundled
+					//	pings) have to be sent before the end of the timestep
+					user_end_of_step_handler ();
+
 					// The pending migration of "flagged" SEs has to be executed,
 					//	the SE to be migrated were previously inserted in the migration
 					//	list due to the receiving of a "NOTIF_MIGR" message sent by 
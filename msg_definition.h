@@ -13,6 +13,7 @@
 #ifndef __MESSAGE_DEFINITION_H
 #define __MESSAGE_DEFINITION_H
 
+#include <stdint.h>
 #include "entity_definition.h"
 
 /*---- M E S S A G E S    D E F I N I T I O N ---------------------------------*/
@@ -23,6 +24,9 @@ typedef struct _link_msg		LinkMsg;		// Network constructions
 #ifdef ADAPTIVE_GOSSIP_SUPPORT
 typedef struct _stimulus_msg		StimulusMsg;		// Stimulus message
 #endif
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+typedef struct _digest_msg		DigestMsg;		// Digest of the cached messages (pull phase)
+#endif
 typedef struct _migr_msg		MigrMsg;		// Migration message
 typedef union   msg			Msg;
 
@@ -35,10 +39,21 @@ typedef union   msg			Msg;
 // **********************************************
 // PING MESSAGES
 // **********************************************
-// Record definition for dynamic part of ping messages (THIS DYNAMIC PART IS NOT USED IN LUNES)
+// Record definition for dynamic part of ping messages
+//	it is used only when ping bundling is enabled (see PING_BUNDLING): all the pings
+//	sent in a timestep to SEs allocated in the same remote LP are packed in a single
+//	message, each record is a whole ping with its receiver and forwarder
 struct _ping_record {
-	unsigned int	key;
-	unsigned int	value;
+	unsigned int	receiver;						// Destination of the bundled ping
+	unsigned int	forwarder;						// Sender of the bundled ping
+	float		timestamp;						// Timestep of creation (of the message)
+	unsigned short	ttl;							// Time-To-Live
+	unsigned int	msgvalue;						// Message Identifier
+	unsigned int	creator;						// ID of the original sender of the message
+
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	unsigned int    num_neighbors;  					// Number of neighbors of forwarder
+	#endif
 };
 //
 // Static part of ping messages
@@ -57,7 +72,7 @@ struct _ping_static_part {
 //
 // Dynamic part of ping messages
 struct _ping_dynamic_part {
-	struct _ping_record	records[MAX_PING_DYNAMIC_RECORDS];		// Adjuntive records
+	struct _ping_record	records[0];					// It is an array of records (at most MAX_PING_DYNAMIC_RECORDS)
 };
 //
 // Ping message
@@ -111,6 +126,38 @@ struct _stimulus_msg {
 #endif
 
 
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+// **********************************************
+// DIGEST MESSAGES
+// **********************************************
+// The pull phase is a three-way exchange, all its control messages have this structure:
+//	-	'D' digest:	IDs of the messages recently cached by the sender
+//	-	'O' offer:	IDs of the messages recently cached by the receiver of the
+//			digest that are not in the digest
+//	-	'Q' request:	IDs of the offered messages that are not in the whole
+//			cache of the sender of the digest
+//	the requested messages are then sent in 'U' type messages, that have
+//	the same structure of pings
+//
+// Static part of digest messages
+struct _digest_static_part {
+	char		type;							// Message type
+	unsigned int	dyn_records;						// Number of message IDs in the dynamic part of the message
+};
+//
+// Dynamic part of digest messages
+struct _digest_dynamic_part {
+	unsigned int	records[0];						// Message IDs (digested, offered or requested)
+};
+//
+// Digest message
+struct _digest_msg {
+	struct	_digest_static_part		digest_static;			// Static part
+	struct	_digest_dynamic_part		digest_dynamic;			// Dynamic part
+};
+#endif
+
+
 // **********************************************
 // MIGRATION MESSAGES
 // **********************************************
@@ -121,6 +168,10 @@ struct _migration_static_part {
 	static_data_t	s_state;						// Static part of the SE state: it is the same
 										//	 of the static part of the simulated entities state
 	unsigned int	dyn_records;						// Number of records in the dynamic part of the message
+	#ifdef ADAPTIVE_GOSSIP_SUPPORT
+	unsigned int	stim_records;						// Number of active stimuli (StimulusElement), they
+										//	are packed just after the records of the dynamic part
+	#endif
 };
 //
 // Dynamic part of ping messages
@@ -144,8 +195,284 @@ union msg {
 	#ifdef ADAPTIVE_GOSSIP_SUPPORT
 	StimulusMsg	stimulus;
 	#endif
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	DigestMsg	digest;
+	#endif
 };
 /*---------------------------------------------------------------------------*/
 
+
+/*---- W I R E    F O R M A T -------------------------------------------------*/
+
+// The model messages (ping, link and stimulus) are not sent as C structures,
+//	that would ship the compiler padding between LPs, but are packed as follows:
+//	-	1 byte, message type
+//	-	1 byte, version of the wire format (WIRE_VERSION)
+//	-	the message fields, always in the same order:
+//		.	identifiers, counters, TTL and degree are varints (7 bits per
+//			byte, the most significant bit is set when another byte follows)
+//		.	timestamp and message identifier are 4 bytes, little-endian
+//
+//	Ping:		type, version, dyn_records, and then
+//			-	if dyn_records == 0: timestamp, ttl, msgvalue, creator, [num_neighbors]
+//			-	otherwise dyn_records times: receiver, forwarder, timestamp,
+//				ttl, msgvalue, creator, [num_neighbors]
+//			(the messages sent in the pull phase, type 'U', are encoded as pings)
+//	Link:		type, version, dyn_records, and then dyn_records times: key, value
+//	Stimulus:	type, version, missing_sender
+//	Digest:		type, version, dyn_records, and then dyn_records times: msgvalue
+//			(also the offers 'O' and the requests 'Q' of the pull phase)
+//
+// The migration messages are managed by GAIA and are still sent as C structures
+
+#define WIRE_VERSION			1
+
+// Upper bounds of the encoded sizes
+#define WIRE_VARINT_MAX_SIZE		5
+#define WIRE_HEADER_MAX_SIZE		(2 + WIRE_VARINT_MAX_SIZE)
+#define WIRE_PING_RECORD_MAX_SIZE	(8 + 5 * WIRE_VARINT_MAX_SIZE)
+#define WIRE_PING_MAX_SIZE		(WIRE_HEADER_MAX_SIZE + WIRE_PING_RECORD_MAX_SIZE)
+#define WIRE_LINK_RECORD_MAX_SIZE	(2 * WIRE_VARINT_MAX_SIZE)
+#define WIRE_STIMULUS_MAX_SIZE		(2 + WIRE_VARINT_MAX_SIZE)
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+#define WIRE_DIGEST_MAX_SIZE		(WIRE_HEADER_MAX_SIZE + 4 * TWO_PHASE_DIGEST_SIZE)
+#endif
+
+// Basic fields
+static inline unsigned char *wire_put_varint (unsigned char *p, uint32_t value) {
+
+	while ( value >= 0x80 ) {
+
+		*p++ = (unsigned char) (value | 0x80);
+		value >>= 7;
+	}
+	*p++ = (unsigned char) value;
+
+	return(p);
+}
+
+static inline uint32_t wire_get_varint (const unsigned char **p) {
+
+	uint32_t	value = 0;
+	unsigned int	shift = 0;
+
+
+	while ( **p & 0x80 ) {
+
+		value |= (uint32_t) (*(*p)++ & 0x7F) << shift;
+		shift += 7;
+	}
+	value |= (uint32_t) *(*p)++ << shift;
+
+	return(value);
+}
+
+static inline unsigned char *wire_put_u32 (unsigned char *p, uint32_t value) {
+
+	p[0] = (unsigned char) value;
+	p[1] = (unsigned char) (value >> 8);
+	p[2] = (unsigned char) (value >> 16);
+	p[3] = (unsigned char) (value >> 24);
+
+	return(p + 4);
+}
+
+static inline uint32_t wire_get_u32 (const unsigned char **p) {
+
+	uint32_t	value;
+
+
+	value = (uint32_t) (*p)[0] | ((uint32_t) (*p)[1] << 8) | ((uint32_t) (*p)[2] << 16) | ((uint32_t) (*p)[3] << 24);
+	*p += 4;
+
+	return(value);
+}
+
+static inline unsigned char *wire_put_float (unsigned char *p, float value) {
+
+	union { float f; uint32_t u; }	bits;
+
+
+	bits.f = value;
+	return(wire_put_u32(p, bits.u));
+}
+
+static inline float wire_get_float (const unsigned char **p) {
+
+	union { float f; uint32_t u; }	bits;
+
+
+	bits.u = wire_get_u32(p);
+	return(bits.f);
+}
+
+// Header (type and version), returns 0 if the wire format version is not supported
+static inline unsigned char *wire_put_header (unsigned char *p, char type) {
+
+	*p++ = (unsigned char) type;
+	*p++ = WIRE_VERSION;
+
+	return(p);
+}
+
+static inline int wire_get_header (const unsigned char **p, char *type) {
+
+	*type = (char) *(*p)++;
+
+	return( *(*p)++ == WIRE_VERSION );
+}
+
+// Ping messages
+//	header and dyn_records, returns the encoded size
+static inline unsigned int wire_encode_ping_header (unsigned char *buffer, unsigned int dyn_records) {
+
+	unsigned char	*p;
+
+
+	p = wire_put_header(buffer, 'P');
+	p = wire_put_varint(p, dyn_records);
+
+	return(p - buffer);
+}
+
+//	single ping (dyn_records is zero), returns the encoded size
+static inline unsigned int wire_encode_ping (unsigned char *buffer, const struct _ping_static_part *ping) {
+
+	unsigned char	*p;
+
+
+	p = wire_put_header(buffer, ping->type);
+	p = wire_put_varint(p, 0);
+	p = wire_put_float(p, ping->timestamp);
+	p = wire_put_varint(p, ping->ttl);
+	p = wire_put_u32(p, ping->msgvalue);
+	p = wire_put_varint(p, ping->creator);
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	p = wire_put_varint(p, ping->num_neighbors);
+	#endif
+
+	return(p - buffer);
+}
+
+//	bundled ping, returns the encoded size
+static inline unsigned int wire_encode_ping_record (unsigned char *buffer, const struct _ping_record *record) {
+
+	unsigned char	*p = buffer;
+
+
+	p = wire_put_varint(p, record->receiver);
+	p = wire_put_varint(p, record->forwarder);
+	p = wire_put_float(p, record->timestamp);
+	p = wire_put_varint(p, record->ttl);
+	p = wire_put_u32(p, record->msgvalue);
+	p = wire_put_varint(p, record->creator);
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	p = wire_put_varint(p, record->num_neighbors);
+	#endif
+
+	return(p - buffer);
+}
+
+//	decodes the static part, the cursor is then left on the first record (if any)
+static inline void wire_decode_ping (const unsigned char **p, struct _ping_static_part *ping) {
+
+	ping->dyn_records = wire_get_varint(p);
+	if ( ping->dyn_records > 0 )	return;
+
+	ping->timestamp = wire_get_float(p);
+	ping->ttl = (unsigned short) wire_get_varint(p);
+	ping->msgvalue = wire_get_u32(p);
+	ping->creator = wire_get_varint(p);
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	ping->num_neighbors = wire_get_varint(p);
+	#endif
+}
+
+static inline void wire_decode_ping_record (const unsigned char **p, struct _ping_record *record) {
+
+	record->receiver = wire_get_varint(p);
+	record->forwarder = wire_get_varint(p);
+	record->timestamp = wire_get_float(p);
+	record->ttl = (unsigned short) wire_get_varint(p);
+	record->msgvalue = wire_get_u32(p);
+	record->creator = wire_get_varint(p);
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	record->num_neighbors = wire_get_varint(p);
+	#endif
+}
+
+// Link messages
+static inline unsigned int wire_encode_link (unsigned char *buffer, const LinkMsg *link) {
+
+	unsigned char	*p;
+	unsigned int	i;
+
+
+	p = wire_put_header(buffer, 'L');
+	p = wire_put_varint(p, link->link_static.dyn_records);
+	for ( i = 0; i < link->link_static.dyn_records; i++ ) {
+
+		p = wire_put_varint(p, link->link_dynamic.records[i].key);
+		p = wire_put_varint(p, link->link_dynamic.records[i].value);
+	}
+
+	return(p - buffer);
+}
+
+//	only the static part is decoded, the cursor is then left on the first record (if any)
+static inline void wire_decode_link (const unsigned char **p, struct _link_static_part *link) {
+
+	link->dyn_records = wire_get_varint(p);
+}
+
+#ifdef ADAPTIVE_GOSSIP_SUPPORT
+// Stimulus messages
+static inline unsigned int wire_encode_stimulus (unsigned char *buffer, const struct _stimulus_static_part *stimulus) {
+
+	unsigned char	*p;
+
+
+	p = wire_put_header(buffer, 'S');
+	p = wire_put_varint(p, stimulus->missing_sender);
+
+	return(p - buffer);
+}
+
+static inline void wire_decode_stimulus (const unsigned char **p, struct _stimulus_static_part *stimulus) {
+
+	stimulus->missing_sender = wire_get_varint(p);
+}
+#endif
+
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+// Digest messages (the type is 'D', 'O' or 'Q')
+static inline unsigned int wire_encode_digest (unsigned char *buffer, char type, const unsigned int *ids, unsigned int count) {
+
+	unsigned char	*p;
+	unsigned int	i;
+
+
+	p = wire_put_header(buffer, type);
+	p = wire_put_varint(p, count);
+	for ( i = 0; i < count; i++ )
+		p = wire_put_u32(p, ids[i]);
+
+	return(p - buffer);
+}
+
+//	decodes at most "max" message IDs, returns the number of IDs in the message
+static inline unsigned int wire_decode_digest (const unsigned char **p, unsigned int *ids, unsigned int max) {
+
+	unsigned int	count, i;
+
+
+	count = wire_get_varint(p);
+	for ( i = 0; ( i < count ) && ( i < max ); i++ )
+		ids[i] = wire_get_u32(p);
+
+	return(count);
+}
+#endif
+
 #endif /* __MESSAGE_DEFINITION_H */
 
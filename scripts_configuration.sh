@@ -34,6 +34,29 @@ SOCKETS=`lscpu | grep "Socket(s)" | cut -d":" -f2 | cut -f14 -d" "`
 COREPERSOCKET=`lscpu | grep "Core(s) per socket" | cut -d":" -f2 | cut -f5 -d" "`
 CPUNUM=`echo $SOCKETS \\* $COREPERSOCKET | bc`
 #
+#	Number of threads used by each stats worker to process the traces of the LPs
+#	(0 = one thread for each LP, bounded by the number of CPUs)
+ANALYZER_THREADS=1
+#
+#	Analysis window of the stats workers, the traces are processed as streams and the
+#	memory is proportional to the messages generated in the window (timesteps)
+#	(0 = the whole coverage table is kept in memory, it must be not shorter than the
+#	maximum delay of the messages, 254 is always enough)
+ANALYZER_WINDOW=254
+#
+#	Kernel of the coverage table of the stats workers:
+#		delays = smallest delay of each (message, node) pair (one byte)
+#		bitset = reached bit of each (message, node) pair, the delay is
+#			 accounted at the first reception (8 times smaller)
+ANALYZER_KERNEL=bitset
+#
+#	Coverage and delay are computed by the simulator during the run
+#	(ONLINE_METRICS=1), the stats workers merge the counts of the LPs
+#	and the traces are not processed, in this case the dissemination
+#	traces can be turned off (DISSEMINATION_TRACE=0)
+export ONLINE_METRICS=0
+export DISSEMINATION_TRACE=1
+#
 #	Reduce the I/O priority of stats workers
 IONICE='ionice -c 3'
 #
@@ -85,6 +108,7 @@ MSGIDS="STAT_msg_ids.txt"
 NODES="STAT_nodes_ids.txt"
 OUTPUT="STAT_coverage.txt"
 DISTRIBUTION="STAT_missing_distribution.txt"
+HISTOGRAM="STAT_delay_histogram.txt"
 #
 #	temporary files
 #
@@ -56,7 +56,8 @@
 /************************ SIMULATOR  LIMITS ********************************/
 
 // Max number of records that can be inserted in a single ping message
-#define	MAX_PING_DYNAMIC_RECORDS	0
+//	(i.e. the max number of pings in a bundle, see PING_BUNDLING in USAGE.TXT)
+#define	MAX_PING_DYNAMIC_RECORDS	1024
 
 // Max number of records that can be inserted in a single migration message
 #define	MAX_MIGRATION_DYNAMIC_RECORDS	1000
@@ -74,14 +75,14 @@
 //	will provide a better scalability
 //#define ADAPTIVE_GOSSIP_SUPPORT
 
-#ifdef ADAPTIVE_GOSSIP_SUPPORT
-// The adaptive gossip algorithms need to statically allocate a quite large amount
-//	of memory for each simulated node, this is the max number of nodes that can
-//	be in the simulated graph
-#define ADAPTIVE_GOSSIP_MAX_NODES	100
-#endif
-
 /***************** DEGREE DEPENDENT GOSSIP *********************************/
 #define DEGREE_DEPENDENT_GOSSIP_SUPPORT
 
+/************************ TWO-PHASE GOSSIP *********************************/
+
+// In the pull phase of the two-phase gossip the messages are sent again, for this
+//	reason the cache of each node stores also their creator and creation time.
+//	It increases the memory used by each node, enable it only when needed
+//#define TWO_PHASE_GOSSIP_SUPPORT
+
 
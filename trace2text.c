@@ -0,0 +1,91 @@
+/*	##############################################################################################
+	Advanced RTI System, ARTÌS			http://pads.cs.unibo.it
+	Large Unstructured NEtwork Simulator (LUNES)
+
+	Description:
+		For a general introduction to LUNES implmentation please see the
+		file: mig-agents.c
+
+		This an external tool used to inspect the simulation traces.
+
+		The goal of this tool is to convert a dissemination trace in binary
+		format (see trace_format.h) in the legacy text format, the output is
+		the same trace file that the simulator would have produced with
+		TRACE_FORMAT=0.
+
+	Authors:
+		First version by Gabriele D'Angelo <g.dangelo@unibo.it>
+
+	###############################################################################################
+*/
+
+/*
+	Input arguments and their semantic:
+
+		argv[1]		Filename of the trace in binary format (input)
+		argv[2]		Filename of the trace in text format (output, optional, default is stdout)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "trace_format.h"
+
+
+int main(int argc, char *argv[]) {
+
+	TraceReader			reader;
+	const struct trace_record	*record;
+	FILE				*output = stdout;
+	unsigned long			records = 0;
+
+
+	if ( ( argc < 2 ) || ( argc > 3 ) ) {
+
+		fprintf(stderr, "Usage: %s TRACE.bin [TRACE.log]\n", argv[0]);
+		exit(1);
+	}
+
+	if ( ! trace_open(&reader, argv[1]) ) {
+
+		fprintf(stderr, "TRACE2TEXT: unable to open the binary trace %s\n", argv[1]);
+		exit(1);
+	}
+
+	if ( ( argc == 3 ) && ( ( output = fopen(argv[2], "w") ) == NULL ) ) {
+
+		fprintf(stderr, "TRACE2TEXT: unable to create the file %s\n", argv[2]);
+		exit(1);
+	}
+
+	while ( ( record = trace_next(&reader) ) != NULL ) {
+
+		switch ( record->type ) {
+
+			// A new message is also received by its creator, the delay is printed with the generation format
+			case TRACE_GENERATED:
+				fprintf(output, "G %010u\n", record->message);
+				fprintf(output, "R %010u %010u %010u\n", record->node, record->message, 0);
+				break;
+
+			case TRACE_TIMESTEP:
+				fprintf(output, "T %010u\n", record->message);
+				break;
+
+			default:
+				fprintf(output, "R %010u %010u %03u\n", record->node, record->message, record->delay);
+				break;
+		}
+
+		records++;
+	}
+
+	trace_close(&reader);
+
+	if ( output != stdout )
+		fclose(output);
+
+	fprintf(stderr, "TRACE2TEXT: %lu records converted\n", records);
+
+	return(0);
+}
@@ -0,0 +1,291 @@
+/*	##############################################################################################
+	Advanced RTI System, ARTÌS			http://pads.cs.unibo.it
+	Large Unstructured NEtwork Simulator (LUNES)
+
+	Description:
+		-	Binary format of the dissemination trace files (SIM_TRACE_<LP>.bin),
+			it is written by the simulator and read by the analysis tools
+			(the trace2text tool converts it in the legacy text format)
+
+	Authors:
+		First version by Gabriele D'Angelo <g.dangelo@unibo.it>
+
+	############################################################################################### */
+
+#ifndef __TRACE_FORMAT_H
+#define __TRACE_FORMAT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// A trace file is composed of a header followed by blocks of records:
+//
+//	header						(struct trace_header)
+//	block header					(struct trace_block_header)
+//	block payload	[size] bytes			(the records of the block, see encoding)
+//	...
+//
+// The records are in simulated time order, a timestep record is written before the
+// first record of each timestep (the text traces contain the same records).
+// Each block contains at most TRACE_BLOCK_RECORDS records, with the encoding:
+//	-	TRACE_BINARY:		array of struct trace_record
+//	-	TRACE_BINARY_COMPACT:	each record is delta encoded with respect to the previous
+//					one of the same block and packed with variable length integers
+//
+// All the fields are in the byte order of the host that created the file
+//
+#define TRACE_MAGIC		0x4352544CU			// "LTRC" in little-endian
+#define TRACE_VERSION		2				// Version of the binary format
+#define TRACE_BLOCK_RECORDS	65536				// Max number of records in a block
+
+// Trace formats (TRACE_FORMAT environment variable)
+#define TRACE_TEXT		0				// Legacy text format (SIM_TRACE_<LP>.log)
+#define TRACE_BINARY		1				// Binary format, fixed size records
+#define TRACE_BINARY_COMPACT	2				// Binary format, compressed blocks
+
+// Record types
+#define TRACE_GENERATED		'G'				// New message, it is also received by its creator (delay 0)
+#define TRACE_RECEIVED		'R'				// Reception of a message
+#define TRACE_TIMESTEP		'T'				// The following records belong to a new timestep (message field)
+
+// Header of the binary trace files
+struct trace_header {
+	uint32_t	magic;						// TRACE_MAGIC
+	uint32_t	version;					// TRACE_VERSION
+	uint32_t	lp;						// LP that has written the trace
+	uint32_t	encoding;					// TRACE_BINARY or TRACE_BINARY_COMPACT
+};
+
+// Header of each block of records
+struct trace_block_header {
+	uint32_t	records;					// Number of records in the block
+	uint32_t	size;						// Size of the payload of the block
+};
+
+// Record of the trace
+struct trace_record {
+	uint32_t	node;						// Receiver (or creator) of the message, original graph ID
+	uint32_t	message;					// Message ID (timestep for TRACE_TIMESTEP records)
+	uint16_t	delay;						// Delay of the reception (timesteps)
+	uint8_t		type;						// TRACE_GENERATED, TRACE_RECEIVED or TRACE_TIMESTEP
+	uint8_t		reserved;
+};
+
+// Compact records: type of the record in the two less significant bits of the first integer
+#define TRACE_COMPACT_RECEIVED	0
+#define TRACE_COMPACT_GENERATED	1
+#define TRACE_COMPACT_TIMESTEP	2
+
+// Max size of a compact record: two 64 bit and one 16 bit variable length integers
+#define TRACE_COMPACT_RECORD_MAX_SIZE	(10 + 10 + 3)
+
+
+// Variable length integers (7 bits for each byte, least significant group first)
+static inline unsigned char *trace_put_varint (unsigned char *p, uint64_t value) {
+
+	while ( value >= 0x80 ) {
+
+		*p++ = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	*p++ = (unsigned char)value;
+
+	return(p);
+}
+
+static inline uint64_t trace_get_varint (const unsigned char **p) {
+
+	uint64_t	value = 0;
+	unsigned int	shift = 0;
+
+
+	while ( **p & 0x80 ) {
+
+		value |= (uint64_t)(*(*p)++ & 0x7F) << shift;
+		shift += 7;
+	}
+	value |= (uint64_t)(*(*p)++) << shift;
+
+	return(value);
+}
+
+// Signed differences are mapped on unsigned integers (zigzag encoding)
+static inline uint32_t trace_zigzag (uint32_t current, uint32_t previous) {
+
+	int32_t	delta = (int32_t)(current - previous);
+
+
+	return ( ( (uint32_t)delta << 1 ) ^ (uint32_t)( delta >> 31 ) );
+}
+
+static inline uint32_t trace_unzigzag (uint32_t value, uint32_t previous) {
+
+	return ( previous + ( ( value >> 1 ) ^ ( 0U - ( value & 1 ) ) ) );
+}
+
+
+/*
+	Compact encoding of a block of records, returns the size of the encoded block
+*/
+static inline uint32_t trace_encode_block (const struct trace_record *records, uint32_t count, unsigned char *buffer) {
+
+	unsigned char	*p = buffer;
+	uint32_t	node = 0, message = 0, kind, i;
+
+
+	for ( i = 0; i < count; i++ ) {
+
+		switch ( records[i].type ) {
+
+			case TRACE_GENERATED:	kind = TRACE_COMPACT_GENERATED;	break;
+			case TRACE_TIMESTEP:	kind = TRACE_COMPACT_TIMESTEP;	break;
+			default:		kind = TRACE_COMPACT_RECEIVED;	break;
+		}
+
+		p = trace_put_varint(p, ( (uint64_t)trace_zigzag(records[i].node, node) << 2 ) | kind);
+		p = trace_put_varint(p, trace_zigzag(records[i].message, message));
+		if ( kind == TRACE_COMPACT_RECEIVED )
+			p = trace_put_varint(p, records[i].delay);
+
+		node = records[i].node;
+		message = records[i].message;
+	}
+
+	return(p - buffer);
+}
+
+
+/*
+	Decoding of a compact block of records
+*/
+static inline void trace_decode_block (const unsigned char *buffer, uint32_t count, struct trace_record *records) {
+
+	const unsigned char	*p = buffer;
+	uint32_t		node = 0, message = 0, i;
+	uint64_t		value;
+
+
+	for ( i = 0; i < count; i++ ) {
+
+		value = trace_get_varint(&p);
+		node = trace_unzigzag((uint32_t)(value >> 2), node);
+		message = trace_unzigzag((uint32_t)trace_get_varint(&p), message);
+
+		records[i].node		= node;
+		records[i].message	= message;
+		records[i].delay	= 0;
+		records[i].reserved	= 0;
+
+		switch ( value & 3 ) {
+
+			case TRACE_COMPACT_GENERATED:
+				records[i].type		= TRACE_GENERATED;
+				break;
+
+			case TRACE_COMPACT_TIMESTEP:
+				records[i].type		= TRACE_TIMESTEP;
+				break;
+
+			default:
+				records[i].type		= TRACE_RECEIVED;
+				records[i].delay	= (uint16_t)trace_get_varint(&p);
+				break;
+		}
+	}
+}
+
+
+/*
+	Sequential reader of the binary trace files
+*/
+typedef struct trace_reader {
+	FILE			*file;
+	uint32_t		encoding;
+	struct trace_record	*records;			// Records of the current block
+	unsigned char		*buffer;			// Payload of the current block (compact encoding)
+	uint32_t		count;				// Number of records in the current block
+	uint32_t		next;				// Next record to be returned
+} TraceReader;
+
+/*
+	Opens a binary trace file, returns 0 if the file does not exist (or it is not a valid trace)
+*/
+static inline int trace_open (TraceReader *reader, const char *filename) {
+
+	struct trace_header	header;
+
+
+	memset(reader, 0, sizeof(TraceReader));
+
+	if ( ( reader->file = fopen(filename, "rb") ) == NULL )
+		return(0);
+
+	if ( 	( fread(&header, sizeof(header), 1, reader->file) != 1 ) ||
+		( header.magic != TRACE_MAGIC ) || ( header.version != TRACE_VERSION ) ) {
+
+		fclose(reader->file);
+		return(0);
+	}
+
+	reader->encoding = header.encoding;
+	reader->records = malloc(TRACE_BLOCK_RECORDS * sizeof(struct trace_record));
+	reader->buffer = malloc(TRACE_BLOCK_RECORDS * TRACE_COMPACT_RECORD_MAX_SIZE);
+	if ( ( reader->records == NULL ) || ( reader->buffer == NULL ) ) {
+
+		fprintf(stderr, "FATAL ERROR, not enough memory to read the trace file %s\n", filename);
+		exit(1);
+	}
+
+	return(1);
+}
+
+/*
+	Next record of the trace, NULL at the end of the file
+*/
+static inline const struct trace_record *trace_next (TraceReader *reader) {
+
+	struct trace_block_header	block;
+
+
+	while ( reader->next == reader->count ) {
+
+		if ( fread(&block, sizeof(block), 1, reader->file) != 1 )
+			return(NULL);
+
+		if ( ( block.records > TRACE_BLOCK_RECORDS ) || ( block.size > TRACE_BLOCK_RECORDS * TRACE_COMPACT_RECORD_MAX_SIZE ) ) {
+
+			fprintf(stderr, "FATAL ERROR, corrupted block in the trace file\n");
+			exit(1);
+		}
+
+		if ( reader->encoding == TRACE_BINARY_COMPACT ) {
+
+			if ( fread(reader->buffer, 1, block.size, reader->file) != block.size )
+				return(NULL);
+			trace_decode_block(reader->buffer, block.records, reader->records);
+		} else {
+
+			if ( fread(reader->records, sizeof(struct trace_record), block.records, reader->file) != block.records )
+				return(NULL);
+		}
+
+		reader->count = block.records;
+		reader->next = 0;
+	}
+
+	return(&reader->records[reader->next++]);
+}
+
+/*
+	Closes a binary trace file
+*/
+static inline void trace_close (TraceReader *reader) {
+
+	fclose(reader->file);
+	free(reader->records);
+	free(reader->buffer);
+}
+
+#endif /* __TRACE_FORMAT_H */
@@ -38,6 +38,7 @@
 #include "lunes.h"
 #include "lunes_constants.h"
 #include "user_event_handlers.h"
+#include "trace_format.h"
 
 /* ************************************************************************ */
 /* 			E X T E R N A L     V A R I A B L E S 	            */
@@ -47,7 +48,6 @@ extern hash_t		hash_table, *table;		/* Global hash table of simulated entities *
 extern hash_t		sim_table, *stable;		/* Hash table of locally simulated entities */
 extern double		simclock;			/* Time management, simulated time */
 extern TSeed		Seed, *S;			/* Seed used for the random generator */
-extern FILE		*fp_print_trace;		/* File descriptor for simulation trace file */
 extern char		*TESTNAME;			/* Test name */
 extern int		LPID;				/* Identification number of the local Logical Process */
 extern int		local_pid;			/* Process identifier */
@@ -63,6 +63,19 @@ extern unsigned short	env_dissemination_mode;		/* Dissemination mode */
 extern float 		env_broadcast_prob_threshold;	/* Dissemination: conditional broadcast, probability threshold */
 extern unsigned int	env_cache_size;			/* Cache size of each node */
 extern float		env_fixed_prob_threshold;	/* Dissemination: fixed probability, probability threshold */
+extern unsigned int	env_fixed_prob_skip_sampling;	/* Dissemination: fixed probability, geometric skip sampling */
+extern unsigned int	env_fanout;			/* Dissemination: fixed fanout, number of neighbors */
+extern unsigned int	env_ping_bundling;		/* Pings directed to the same remote LP are bundled */
+extern unsigned int	env_local_links;		/* Both the directions of each edge are built at load time */
+extern unsigned int	env_trace_format;		/* Format of the dissemination trace files */
+extern unsigned int	env_trace_first_receptions;	/* Only the first receptions are traced */
+extern unsigned int	env_dissemination_trace;	/* The dissemination trace files are written */
+extern unsigned int	env_online_metrics;		/* Coverage and delay are computed during the run */
+extern unsigned int	env_online_metrics_window;	/* Online metrics: timesteps in which a message can be received */
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+extern float		env_pull_period;		/* Dissemination: two-phase gossip, timesteps between two digests */
+extern unsigned int	env_pull_max_age;		/* Dissemination: two-phase gossip, max age of the pulled messages */
+#endif
 #ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
 extern unsigned int env_probability_function;		/* Probability function for Degree Dependent Gossip */
 extern double       env_function_coefficient;		/* Coefficient of probability function */
@@ -76,6 +89,25 @@ extern double       env_function_coefficient;		/* Coefficient of probability fun
 // Total number of sent and received pings in this LP, for statistics
 unsigned long	lp_total_sent_pings 	= 0;
 unsigned long	lp_total_received_pings = 0;
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+// Total number of sent control messages (digests, offers and requests) and pulled
+//	messages in this LP (pull phase of the two-phase gossip)
+unsigned long	lp_total_sent_digests	= 0;
+unsigned long	lp_total_sent_pulled	= 0;
+#endif
+
+// Pings directed to SEs allocated in a remote LP, waiting to be sent in a single message
+typedef struct ping_bundle {
+	double		ts;				// Delivery time of the bundled pings
+	int		from;				// SE used as sender of the bundle
+	int		to;				// SE used as receiver of the bundle (it is in the remote LP)
+	unsigned int	records;			// Number of bundled pings
+	unsigned int	size;				// Size of the encoded pings
+	unsigned char	*buffer;			// Bundle, the header is added in front of the pings when sent
+} PingBundle;
+
+// One bundle for each LP (only if the ping bundling is enabled)
+PingBundle	*ping_bundles = NULL;
 
 
 /* ************************************************************************ */
@@ -148,6 +180,24 @@ unsigned long	get_total_received_pings () {
 	return(lp_total_received_pings);
 }
 
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+/*
+	Statistics: exports the total number of SENT digest messages (digests, offers and requests)
+*/
+unsigned long	get_total_sent_digests () {
+
+	return(lp_total_sent_digests);
+}
+
+/*
+	Statistics: exports the total number of SENT pulled messages
+*/
+unsigned long	get_total_sent_pulled () {
+
+	return(lp_total_sent_pulled);
+}
+#endif
+
 
 /*
 	Utility to check environment variables, if the variable is not defined then the run is aborted
@@ -257,13 +307,88 @@ int	modify_entity_state_entry (unsigned int key, unsigned int new_value, hash_no
 /* ********************** I N T E R A C T I O N S ***************************/
 
 
+/*
+	Sends the pings that are pending in the bundle of a given LP
+*/
+static void	flush_ping_bundle (PingBundle *bundle) {
+
+	unsigned char	header[WIRE_HEADER_MAX_SIZE];
+	unsigned char	*message;
+	unsigned int	header_size, message_size;
+
+
+	if ( bundle->records == 0 )	return;
+
+	// The header is placed just before the encoded pings, the space is reserved
+	header_size = wire_encode_ping_header(header, bundle->records);
+	message = bundle->buffer + WIRE_HEADER_MAX_SIZE - header_size;
+	memcpy(message, header, header_size);
+
+	message_size = header_size + bundle->size;
+
+	// Buffer check
+	if (message_size > BUFFER_SIZE) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, the outgoing BUFFER_SIZE is not sufficient!\n", simclock);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	// Real send
+	GAIA_Send (bundle->from, bundle->to, bundle->ts, (void *)message, message_size);
+
+	bundle->records = 0;
+	bundle->size = 0;
+}
+
+
+/*
+	Appends a ping to the bundle of the LP that manages its receiver,
+	the bundle is sent when full or at the end of the timestep
+*/
+static void	bundle_ping (double ts, hash_node_t *src, dir_data_t *dest, struct _ping_static_part *ping) {
+
+	PingBundle		*bundle = &ping_bundles[dest->lp];
+	struct _ping_record	record;
+
+
+	// All the pings in a bundle have to be delivered at the same time
+	if ( ( bundle->records > 0 ) && ( bundle->ts != ts ) )
+		flush_ping_bundle (bundle);
+
+	if ( bundle->records == 0 ) {
+
+		bundle->ts   = ts;
+		bundle->from = src->dir->key;
+		bundle->to   = dest->key;
+	}
+
+	record.receiver		= dest->key;
+	record.forwarder	= src->dir->key;
+	record.timestamp	= ping->timestamp;
+	record.ttl		= ping->ttl;
+	record.msgvalue		= ping->msgvalue;
+	record.creator		= ping->creator;
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	record.num_neighbors	= ping->num_neighbors;
+	#endif
+
+	bundle->size += wire_encode_ping_record (bundle->buffer + WIRE_HEADER_MAX_SIZE + bundle->size, &record);
+	bundle->records++;
+
+	if ( bundle->records == MAX_PING_DYNAMIC_RECORDS )
+		flush_ping_bundle (bundle);
+}
+
+
 /*
   	Ping another SE, creating and sending a 'P' type message
 	Usually called by user_generate_interactions_handler ()
  */
-void	execute_ping (double ts, hash_node_t *src, hash_node_t *dest, unsigned short ttl, unsigned int value_to_send, double timestamp, unsigned int creator) {
+void	execute_ping (double ts, hash_node_t *src, dir_data_t *dest, unsigned short ttl, unsigned int value_to_send, double timestamp, unsigned int creator) {
 
 	PingMsg		msg;
+	unsigned char	buffer[WIRE_PING_MAX_SIZE];
 	unsigned int	message_size;
 
 
@@ -283,17 +408,49 @@ void	execute_ping (double ts, hash_node_t *src, hash_node_t *dest, unsigned shor
 	// In this specific case, the number of records in the ping message is set to zero
 	msg.ping_static.dyn_records = 0;
 
-	// To reduce the network overhead, only the used part of the message is really sent
-	message_size = sizeof(struct _ping_static_part) + (msg.ping_static.dyn_records * sizeof(struct _ping_record));
+	// Pings to remote LPs can be packed in a single message
+	if ( env_ping_bundling && ( dest->lp != LPID ) ) {
 
-	// Dynamic boudaries check
-	if (msg.ping_static.dyn_records > MAX_PING_DYNAMIC_RECORDS) {
+		bundle_ping (ts, src, dest, &msg.ping_static);
+
+		// Statistics
+		lp_total_sent_pings++;
+		return;
+	}
 
-		fprintf(stdout, "%12.2f FATAL ERROR, the number of entries in the dynamic part of the ping message is bigger than MAX_PING_DYNAMIC_RECORDS!\n", simclock);
+	// To reduce the network overhead, the message is sent in the packed wire format
+	message_size = wire_encode_ping(buffer, &msg.ping_static);
+
+	// Buffer check
+	if (message_size > BUFFER_SIZE) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, the outgoing BUFFER_SIZE is not sufficient!\n", simclock);
 		fflush(stdout);
 		exit(-1);
 	}
 
+	// Real send
+	GAIA_Send (src->dir->key, dest->key, ts, (void *)buffer, message_size);
+
+	// Statistics
+	lp_total_sent_pings++;
+}
+
+
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+/*
+	Sends a list of message IDs to another SE (pull phase), creating and sending
+	a 'D' (digest), 'O' (offer) or 'Q' (request) type message
+ */
+void	execute_digest (double ts, hash_node_t *src, dir_data_t *dest, char type, const unsigned int *ids, unsigned int count) {
+
+	unsigned char	buffer[WIRE_DIGEST_MAX_SIZE];
+	unsigned int	message_size;
+
+
+	// To reduce the network overhead, the message is sent in the packed wire format
+	message_size = wire_encode_digest(buffer, type, ids, count);
+
 	// Buffer check
 	if (message_size > BUFFER_SIZE) {
 
@@ -303,13 +460,59 @@ void	execute_ping (double ts, hash_node_t *src, hash_node_t *dest, unsigned shor
 	}
 
 	// Real send
-	GAIA_Send (src->data->key, dest->data->key, ts, (void *)&msg, message_size);
+	GAIA_Send (src->dir->key, dest->key, ts, (void *)buffer, message_size);
 
 	// Statistics
-	lp_total_sent_pings++;
+	lp_total_sent_digests++;
 }
 
 
+/*
+	Sends a message that is missing in the digest of another SE,
+	creating and sending a 'U' type message (pull phase)
+	Note: the pulled messages are never forwarded and therefore their TTL is zero
+ */
+void	execute_pulled (double ts, hash_node_t *src, dir_data_t *dest, unsigned int value_to_send, double timestamp, unsigned int creator) {
+
+	PingMsg		msg;
+	unsigned char	buffer[WIRE_PING_MAX_SIZE];
+	unsigned int	message_size;
+
+
+	// Defining the message type
+	msg.ping_static.type = 'U';
+
+	msg.ping_static.timestamp = timestamp;
+	msg.ping_static.ttl = 0;
+	msg.ping_static.msgvalue = value_to_send;
+	msg.ping_static.creator = creator;
+
+	#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+	msg.ping_static.num_neighbors = src->data->num_neighbors;
+	#endif
+
+	msg.ping_static.dyn_records = 0;
+
+	// To reduce the network overhead, the message is sent in the packed wire format
+	message_size = wire_encode_ping(buffer, &msg.ping_static);
+
+	// Buffer check
+	if (message_size > BUFFER_SIZE) {
+
+		fprintf(stdout, "%12.2f FATAL ERROR, the outgoing BUFFER_SIZE is not sufficient!\n", simclock);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	// Real send
+	GAIA_Send (src->dir->key, dest->key, ts, (void *)buffer, message_size);
+
+	// Statistics, the pulled messages are not accounted as pings
+	lp_total_sent_pulled++;
+}
+#endif
+
+
 /*
   	Links another SE, creating and sending a 'L' type message
 	In LUNES it is used to build up the graph structure that has been read
@@ -317,17 +520,18 @@ void	execute_ping (double ts, hash_node_t *src, hash_node_t *dest, unsigned shor
  */
 void	execute_link (double ts, hash_node_t *src, hash_node_t *dest) {
 	LinkMsg		msg;
+	unsigned char	buffer[WIRE_HEADER_MAX_SIZE];
 	unsigned int	message_size;
 
 
 	// Defining the message type
 	msg.link_static.type = 'L';
 
-	// The number of records in the ping message is chosen at random
+	// No records are used in the link message
 	msg.link_static.dyn_records = 0;
 
-	// To reduce the network overhead, only the used part of the message is really sent
-	message_size = sizeof(struct _link_static_part);
+	// To reduce the network overhead, the message is sent in the packed wire format
+	message_size = wire_encode_link(buffer, &msg);
 
 	// Buffer check
 	if (message_size > BUFFER_SIZE) {
@@ -338,7 +542,7 @@ void	execute_link (double ts, hash_node_t *src, hash_node_t *dest) {
 	}
 
 	// Real send
-	GAIA_Send (src->data->key, dest->data->key, ts, (void *)&msg, message_size);
+	GAIA_Send (src->dir->key, dest->dir->key, ts, (void *)buffer, message_size);
 }
 
 
@@ -356,6 +560,7 @@ void	execute_link (double ts, hash_node_t *src, hash_node_t *dest) {
 */
 void	user_ping_event_handler (hash_node_t *node, int forwarder, Msg *msg) {
 	float difference;
+	int first;
 
 
 	// Statistics	
@@ -367,13 +572,90 @@ void	user_ping_event_handler (hash_node_t *node, int forwarder, Msg *msg) {
 
 	difference = simclock - msg->ping.ping_static.timestamp;
 
+	// Calling the appropriate LUNES user level handler
+	first = lunes_user_ping_event_handler (node, forwarder, msg);
+
+	// Statistics: online metrics, only the messages that were not cached (the cache is migrated with the SE)
+	if ( env_online_metrics && first )
+		lunes_metrics_received(node->data->key, msg->ping.ping_static.msgvalue, msg->ping.ping_static.timestamp);
+
+	// Statistics: all the receptions or only the first ones are traced
 	#ifdef TRACE_DISSEMINATION
-	fprintf(fp_print_trace, "R %010u %010u %03u\n", node->data->key, msg->ping.ping_static.msgvalue, (int)difference);
+	if ( first || ! env_trace_first_receptions )
+		lunes_trace_received(node->data->key, msg->ping.ping_static.msgvalue, (int)difference);
 	#endif
+}
+
+
+/****************************************************************************
+	PING BUNDLE: a set of pings directed to SEs allocated in this LP has been
+	received in a single message, each ping is delivered to its receiver
+*/
+void	user_ping_bundle_event_handler (unsigned int records, const unsigned char *cursor) {
+
+	PingMsg			ping;
+	struct _ping_record	record;
+	hash_node_t		*node;
+	unsigned int		i;
+
+
+	ping.ping_static.type = 'P';
+	ping.ping_static.dyn_records = 0;
+
+	for ( i = 0; i < records; i++ ) {
+
+		wire_decode_ping_record (&cursor, &record);
+
+		if ( ( node = hash_lookup(stable, record.receiver) ) == NULL ) {
+
+			fprintf(stdout, "%12.2f FATAL ERROR, the receiver [%5d] of a bundled ping is not allocated in this LP!\n", simclock, record.receiver);
+			fflush(stdout);
+			exit(-1);
+		}
+
+		ping.ping_static.timestamp	= record.timestamp;
+		ping.ping_static.ttl		= record.ttl;
+		ping.ping_static.msgvalue	= record.msgvalue;
+		ping.ping_static.creator	= record.creator;
+		#ifdef DEGREE_DEPENDENT_GOSSIP_SUPPORT
+		ping.ping_static.num_neighbors	= record.num_neighbors;
+		#endif
+
+		// Only the static part is used by the ping handler
+		user_ping_event_handler (node, record.forwarder, (Msg *)&ping);
+	}
+}
+
+
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+/****************************************************************************
+	PULLED: a message that was missing in the digest of this node has been
+	received (pull phase of the two-phase gossip)
+*/
+void	user_pulled_event_handler (hash_node_t *node, int forwarder, Msg *msg) {
+	float difference;
+	int first;
+
+
+	// Statistics	
+	lp_total_received_pings++;
+
+	difference = simclock - msg->ping.ping_static.timestamp;
 
 	// Calling the appropriate LUNES user level handler
-	lunes_user_ping_event_handler (node, forwarder, msg);
+	first = lunes_user_pulled_event_handler (node, forwarder, msg);
+
+	// Statistics: online metrics, only the messages that were not cached (the cache is migrated with the SE)
+	if ( env_online_metrics && first )
+		lunes_metrics_received(node->data->key, msg->ping.ping_static.msgvalue, msg->ping.ping_static.timestamp);
+
+	// Statistics: all the receptions or only the first ones are traced
+	#ifdef TRACE_DISSEMINATION
+	if ( first || ! env_trace_first_receptions )
+		lunes_trace_received(node->data->key, msg->ping.ping_static.msgvalue, (int)difference);
+	#endif
 }
+#endif
 
 
 /****************************************************************************
@@ -382,17 +664,9 @@ void	user_ping_event_handler (hash_node_t *node, int forwarder, Msg *msg) {
 void	user_link_event_handler (hash_node_t *node, int id, Msg *msg) {
 
 	value_element	val;
-	#ifdef ADAPTIVE_GOSSIP_SUPPORT
-	int 		i;
-	#endif
 
 	val.value = id;
 
-	#ifdef ADAPTIVE_GOSSIP_SUPPORT	
-	for ( i = 0; i < NSIMULATE * NLP; i++)	val.stim_timeout[i] = 0;
-	for ( i = 0; i < NSIMULATE * NLP; i++)	val.stim_increment[i] = 0;
-	#endif
-
 	// Adding a new entry in the local state of the registering node
 	//	first entry	= key
 	//	second entry	= value
@@ -420,6 +694,13 @@ void	user_register_event_handler (hash_node_t *node, int id) {
 	// Initializing the local data structures of the node		
 	node->data->state = g_hash_table_new_full( g_int_hash, g_int_equal, g_free, NULL );
 
+	// The compact table of neighbors is built at the end of the building phase
+	node->data->degree		= 0;
+	node->data->neighbors		= NULL;
+	node->data->neighbors_data	= NULL;
+	node->data->neighbors_dir	= NULL;
+	node->data->neighbors_owned	= NO;
+
 	// Calling the appropriate LUNES user level handler
 	lunes_user_register_event_handler ( node );
 }
@@ -456,10 +737,14 @@ void	user_notify_ext_migration_event_handler () {
 	SE's local state
 */
 void	user_migration_event_handler (hash_node_t *node, int id, Msg *msg) {
-	int		tmp;
 
 	// Initializing the local data structures of the node		
-	node->data->state = g_hash_table_new_full(g_int_hash, g_int_equal, g_free, NULL);
+	node->data->state		= NULL;
+	node->data->degree		= 0;
+	node->data->neighbors		= NULL;
+	node->data->neighbors_data	= NULL;
+	node->data->neighbors_dir	= NULL;
+	node->data->neighbors_owned	= NO;
 
 	// The migration message contains the state of the migrating SE,
 	//	after allocating space to locally manage the node, I've
@@ -468,22 +753,9 @@ void	user_migration_event_handler (hash_node_t *node, int id, Msg *msg) {
 	//
 	// Static part
 	node->data->s_state = msg->migr.migration_static.s_state;
-	// Dynamic part
-	for ( tmp = 0; tmp < msg->migr.migration_static.dyn_records; tmp++ ) {
-
-		// Adding a new entry in the local state of the migrated node (rebuilds its local state)
-		//	first entry	= key
-		//	second entry	= value
-		//	note: no duplicates are allowed
-		if ( add_entity_state_entry( msg->migr.migration_dynamic.records[tmp].key, 
-			&(msg->migr.migration_dynamic.records[tmp].elements), id, node ) == -1 ) {
-
-			// Insertion aborted, the key is already in the hash table
-			fprintf(stdout, "%12.2f node: FATAL ERROR, [%5d] key %d (value %d) is a duplicate and can not be inserted in the hash table of local state\n", simclock, id, msg->migr.migration_dynamic.records[tmp].key, msg->migr.migration_dynamic.records[tmp].elements.value);
-			fflush(stdout);
-			exit(-1);
-		}
-	}
+
+	// Dynamic part (neighbors), calling the appropriate LUNES user level handler
+	lunes_user_migration_event_handler (node, id, msg);
 }
 
 
@@ -501,25 +773,56 @@ void	user_control_handler () {
 	if ( simclock == (float) BUILDING_STEP ) {
 		// Loading the graph topology that was previously generated
 		lunes_load_graph_topology();
+
+		// No link messages have been sent, the topology is already complete
+		if ( env_local_links )
+			lunes_compact_topology();
+	}
+
+	// The building phase is finished, the topology will not change anymore
+	if ( ( ! env_local_links ) && ( simclock == (float) EXECUTION_STEP ) ) {
+		// Moving the neighbors of local SEs in a compact table
+		lunes_compact_topology();
 	}
 
 	// Only if in the aggregation phase is finished &&
 	// if it is possible to send messages up to the last simulated timestep then the statistics will be
 	// affected by some messages that have been sent but with no time to be received
-	if ( ( simclock >= (float) EXECUTION_STEP) && ( simclock <  ( env_end_clock - MAX_TTL ) ) ) {
+	if ( ( simclock >= (float) ( env_local_links ? BUILDING_STEP : EXECUTION_STEP ) ) && ( simclock <  ( env_end_clock - MAX_TTL ) ) ) {
 
 		// For each local SE
-	   	for ( h = 0; h < stable->size; h++ ) {
-			for ( node = stable->bucket[h]; node; node = node->next) {	
+	   	for ( h = 0; h < stable->count; h++ ) {
 
-				// Calling the appropriate LUNES user level handler			
-				lunes_user_control_handler ( node );
-			}
+			node = stable->list[h];
+
+			// Calling the appropriate LUNES user level handler			
+			lunes_user_control_handler ( node );
 		}
 	}
 }
 
 
+/*****************************************************************************
+	END OF STEP: the timestep is finished, the pending model level messages
+	have to be sent
+*/
+void	user_end_of_step_handler () {
+
+	int	lp;
+
+
+	// Online metrics: the messages that cannot be received anymore are released
+	if ( env_online_metrics )
+		lunes_metrics_release();
+
+	if ( env_ping_bundling ) {
+
+		for ( lp = 0; lp < NLP; lp++ )
+			flush_ping_bundle (&ping_bundles[lp]);
+	}
+}
+
+
 /*****************************************************************************
 	USER MODEL: when it is received a model level interaction, after some 
 	validation this generic handler is called. The specific user level 
@@ -527,25 +830,84 @@ void	user_control_handler () {
 */
 void	user_model_events_handler (int to, int from, Msg *msg, hash_node_t *node) {
 
+	const unsigned char	*cursor = (const unsigned char *) msg;
+	char			type;
+	PingMsg			ping;
+	LinkMsg			link;
+	#ifdef ADAPTIVE_GOSSIP_SUPPORT
+	StimulusMsg		stimulus;
+	#endif
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	unsigned int		ids[TWO_PHASE_DIGEST_SIZE];
+	unsigned int		count;
+	#endif
+
+
+	// Model events are received in the packed wire format
+	if ( ! wire_get_header(&cursor, &type) ) {
+
+		fprintf(stdout, "FATAL ERROR, received a user model event (type: %d) with an unsupported wire format version: %d\n", type, cursor[-1]);
+		fflush(stdout);
+		exit(-1);
+	}
+
 	// A model event has been received, now calling appropriate user level handler
-	switch ( msg->type ) {
+	switch ( type ) {
+
+		case 'P':	// Ping message (or a bundle of pings)
+			ping.ping_static.type = type;
+			wire_decode_ping(&cursor, &ping.ping_static);
 
-		case 'P':	// Ping message 
-			user_ping_event_handler(node, from, msg);
+			if ( ping.ping_static.dyn_records == 0 )
+				user_ping_event_handler(node, from, (Msg *)&ping);
+			else	user_ping_bundle_event_handler(ping.ping_static.dyn_records, cursor);
 		break;
 
 		case 'L':	// Link message
-			user_link_event_handler(node, from, msg);
+			link.link_static.type = type;
+			wire_decode_link(&cursor, &link.link_static);
+
+			user_link_event_handler(node, from, (Msg *)&link);
 		break;
 
 		#ifdef ADAPTIVE_GOSSIP_SUPPORT
 		case 'S':	// Stimulus message
-			lunes_user_stimulus_event_handler(node, from, msg);
+			stimulus.stimulus_static.type = type;
+			wire_decode_stimulus(&cursor, &stimulus.stimulus_static);
+
+			lunes_user_stimulus_event_handler(node, from, (Msg *)&stimulus);
+		break;
+		#endif
+
+		#ifdef TWO_PHASE_GOSSIP_SUPPORT
+		case 'D':	// Digest message
+		case 'O':	// Offer message
+		case 'Q':	// Request message
+			count = wire_decode_digest(&cursor, ids, TWO_PHASE_DIGEST_SIZE);
+			if ( count > TWO_PHASE_DIGEST_SIZE ) {
+
+				fprintf(stdout, "FATAL ERROR, received a digest with %u message IDs, see constant TWO_PHASE_DIGEST_SIZE in file: lunes_constants.h\n", count);
+				fflush(stdout);
+				exit(-1);
+			}
+
+			if ( type == 'D' )
+				lunes_user_digest_event_handler(node, from, ids, count);
+			else if ( type == 'O' )
+				lunes_user_offer_event_handler(node, from, ids, count);
+			else	lunes_user_request_event_handler(node, from, ids, count);
+		break;
+
+		case 'U':	// Pulled message
+			ping.ping_static.type = type;
+			wire_decode_ping(&cursor, &ping.ping_static);
+
+			user_pulled_event_handler(node, from, (Msg *)&ping);
 		break;
 		#endif
 
 		default:
-			fprintf(stdout, "FATAL ERROR, received an unknown user model event type: %d\n", msg->type);
+			fprintf(stdout, "FATAL ERROR, received an unknown user model event type: %d\n", type);
 			fflush(stdout);
 			exit(-1);
 	}
@@ -626,6 +988,21 @@ void	user_environment_handler () {
 
 				fprintf(stdout, "LUNES____[%10d]:  FIXED_PROB_THRESHOLD is out of the boundaries!!!\n", local_pid);
 			}		
+
+			//	Runtime configuration:	selection of the neighbors using a geometric skip sampling (optional, default is OFF)
+			if ( getenv("FIXED_PROB_SKIP_SAMPLING") != NULL )	env_fixed_prob_skip_sampling = atoi(getenv("FIXED_PROB_SKIP_SAMPLING"));
+			fprintf(stdout, "LUNES____[%10d]: FIXED_PROB_SKIP_SAMPLING, geometric skip sampling of the neighbors -> %d\n", local_pid, env_fixed_prob_skip_sampling);
+		break;
+
+		case GOSSIP_FIXED_FANOUT:	//	gossip with fixed fanout
+
+			//	Runtime configuration:	number of neighbors that receive each forwarded message
+			env_fanout = atoi(check_and_getenv("FANOUT"));
+			fprintf(stdout, "LUNES____[%10d]: FANOUT, number of neighbors of the fixed fanout dissemination -> %u\n", local_pid, env_fanout);
+			if ( env_fanout == 0 ) {
+
+				fprintf(stdout, "LUNES____[%10d]: FANOUT is 0, the messages will not be forwarded!!!\n", local_pid);
+			}
 		break;
 
 		#ifdef ADAPTIVE_GOSSIP_SUPPORT
@@ -657,10 +1034,48 @@ void	user_environment_handler () {
 		break;
 		#endif
 
+		#ifdef TWO_PHASE_GOSSIP_SUPPORT
+		case TWO_PHASE_GOSSIP:		//	two-phase gossip: fixed probability push, digest-based pull
+
+			//	Runtime configuration:	probability threshold of the push phase
+			env_fixed_prob_threshold = atof(check_and_getenv("FIXED_PROB_THRESHOLD"));
+			fprintf(stdout, "LUNES____[%10d]: FIXED_PROB_THRESHOLD, probability of the push phase -> %f\n", local_pid, env_fixed_prob_threshold);
+			if ( ( env_fixed_prob_threshold < 0 ) || ( env_fixed_prob_threshold > 100 ) ) {
+
+				fprintf(stdout, "LUNES____[%10d]:  FIXED_PROB_THRESHOLD is out of the boundaries!!!\n", local_pid);
+			}		
+
+			//	Runtime configuration:	selection of the neighbors using a geometric skip sampling (optional, default is OFF)
+			if ( getenv("FIXED_PROB_SKIP_SAMPLING") != NULL )	env_fixed_prob_skip_sampling = atoi(getenv("FIXED_PROB_SKIP_SAMPLING"));
+			fprintf(stdout, "LUNES____[%10d]: FIXED_PROB_SKIP_SAMPLING, geometric skip sampling of the neighbors -> %d\n", local_pid, env_fixed_prob_skip_sampling);
+
+			//	Runtime configuration:	period of the pull phase
+			env_pull_period = atof(check_and_getenv("PULL_PERIOD"));
+			fprintf(stdout, "LUNES____[%10d]: PULL_PERIOD, timesteps between two digests sent by each node -> %f\n", local_pid, env_pull_period);
+			if ( env_pull_period < 1 ) {
+
+				fprintf(stdout, "LUNES____[%10d]: FATAL ERROR, PULL_PERIOD has to be at least 1!!!\n", local_pid);
+				fflush(stdout);
+				exit(-1);
+			}
+
+			//	Runtime configuration:	max age of the pulled messages (optional, default is one pull round after
+			//	the push phase: MAX_TTL + 1, then PULL_PERIOD and the digest, offer, request and pulled messages)
+			env_pull_max_age = (unsigned int) ( env_max_ttl + 1 + ceil(env_pull_period) + ( 4 * FLIGHT_TIME ) );
+			if ( getenv("PULL_MAX_AGE") != NULL )	env_pull_max_age = atoi(getenv("PULL_MAX_AGE"));
+			if ( env_pull_max_age > TWO_PHASE_MAX_AGE ) {
+
+				fprintf(stdout, "LUNES____[%10d]:  PULL_MAX_AGE is bigger that TWO_PHASE_MAX_AGE (%d) and therefore it is set to the maximum\n", local_pid, TWO_PHASE_MAX_AGE);
+				env_pull_max_age = TWO_PHASE_MAX_AGE;
+			}
+			fprintf(stdout, "LUNES____[%10d]: PULL_MAX_AGE, max age of the pulled messages -> %d\n", local_pid, env_pull_max_age);
+		break;
+		#endif
+
 		default:
 
 			fprintf(stdout, "LUNES____[%10d]: FATAL ERROR, the dissemination mode [%2d] is NOT implemented in this version of LUNES!!!\n", local_pid, env_dissemination_mode);
-			fprintf(stdout, "LUNES____[%10d]: NOTE, all the adaptive protocols require compile time support, see the ADAPTIVE_GOSSIP_SUPPORT define in sim-parameters.h\n", local_pid);
+			fprintf(stdout, "LUNES____[%10d]: NOTE, all the adaptive protocols require compile time support, see the ADAPTIVE_GOSSIP_SUPPORT and TWO_PHASE_GOSSIP_SUPPORT defines in sim-parameters.h\n", local_pid);
 			fflush(stdout);
 			exit(-1);
 		break;
@@ -677,21 +1092,80 @@ void	user_environment_handler () {
 		fprintf(stdout, "LUNES____[%10d]:  CACHE_SIZE is bigger that MAX_CACHE_SIZE (%d) and therefore the cache is set to the maximum\n", local_pid, MAX_CACHE_SIZE);
 		env_cache_size = MAX_CACHE_SIZE;
 	}
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	// The digests of the pull phase are built from the cache content
+	if ( ( env_dissemination_mode == TWO_PHASE_GOSSIP ) && ( env_cache_size == 0 ) ) {
 
-	#ifdef ADAPTIVE_GOSSIP_SUPPORT
-	// Checking some constraints
-	
-	// If an adaptive protocol is used then I've to check that the number of nodes in the graph
-	// is within the static limit that has been defined at compile time for the support data
-	// structure used in this dissemination protocol
-	if ( ( NSIMULATE * NLP ) > ADAPTIVE_GOSSIP_MAX_NODES) {
+		fprintf(stdout, "LUNES____[%10d]: FATAL ERROR, the two-phase gossip requires the cache (CACHE_SIZE > 0)!!!\n", local_pid);
+		fflush(stdout);
+		exit(-1);
+	}
+	#endif
 
-		fprintf(stdout, "LUNES____[%10d]: FATAL ERROR, the adaptive dissemination protocol [%2d] is used and the numer of nodes in the graph (%5d) is too high!\n", local_pid, env_dissemination_mode, NSIMULATE * NLP);
-		fprintf(stdout, "LUNES____[%10d]: the compile time limit ADAPTIVE_GOSSIP_MAX_NODES is now set to (%5d) and is defined in sim-parameters.h\n", local_pid, ADAPTIVE_GOSSIP_MAX_NODES);
+	//	Runtime configuration:	local construction of the links (optional, default is OFF)
+	//
+	if ( getenv("LOCAL_LINKS") != NULL )	env_local_links = atoi(getenv("LOCAL_LINKS"));
+	fprintf(stdout,"LUNES____[%10d]: LOCAL_LINKS, both the directions of each edge are built at load time: %d\n", local_pid, env_local_links);
+
+	//	Runtime configuration:	format of the dissemination trace files (optional, default is text)
+	//
+	if ( getenv("TRACE_FORMAT") != NULL )	env_trace_format = atoi(getenv("TRACE_FORMAT"));
+	fprintf(stdout,"LUNES____[%10d]: TRACE_FORMAT, format of the dissemination trace files (0 text, 1 binary, 2 compact binary): %d\n", local_pid, env_trace_format);
+	if ( env_trace_format > TRACE_BINARY_COMPACT ) {
+
+		fprintf(stdout, "LUNES____[%10d]: FATAL ERROR, the TRACE_FORMAT %d is not supported!!!\n", local_pid, env_trace_format);
 		fflush(stdout);
 		exit(-1);
 	}
+
+	//	Runtime configuration:	only the first receptions are traced (optional, default is OFF)
+	//
+	if ( getenv("TRACE_FIRST_RECEPTIONS") != NULL )	env_trace_first_receptions = atoi(getenv("TRACE_FIRST_RECEPTIONS"));
+	fprintf(stdout,"LUNES____[%10d]: TRACE_FIRST_RECEPTIONS, only the receptions of messages that are not cached are traced: %d\n", local_pid, env_trace_first_receptions);
+
+	//	Runtime configuration:	dissemination trace files (optional, default is ON)
+	//
+	if ( getenv("DISSEMINATION_TRACE") != NULL )	env_dissemination_trace = atoi(getenv("DISSEMINATION_TRACE"));
+	fprintf(stdout,"LUNES____[%10d]: DISSEMINATION_TRACE, the dissemination trace files are written: %d\n", local_pid, env_dissemination_trace);
+
+	//	Runtime configuration:	online coverage and delay metrics (optional, default is OFF)
+	//
+	if ( getenv("ONLINE_METRICS") != NULL )	env_online_metrics = atoi(getenv("ONLINE_METRICS"));
+	fprintf(stdout,"LUNES____[%10d]: ONLINE_METRICS, coverage and delay of the messages are computed during the run: %d\n", local_pid, env_online_metrics);
+
+	//	Runtime configuration:	online metrics, timesteps in which a message can be received
+	//	(optional, default is the max delay of the messages: MAX_TTL + 1 in the push-based
+	//	dissemination, the max age of the pulled messages in the two-phase gossip)
+	//
+	env_online_metrics_window = env_max_ttl + 1;
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	if ( ( env_dissemination_mode == TWO_PHASE_GOSSIP ) && ( env_pull_max_age > env_online_metrics_window ) )
+		env_online_metrics_window = env_pull_max_age;
 	#endif
+	if ( getenv("ONLINE_METRICS_WINDOW") != NULL )	env_online_metrics_window = atoi(getenv("ONLINE_METRICS_WINDOW"));
+	if ( env_online_metrics )
+		fprintf(stdout,"LUNES____[%10d]: ONLINE_METRICS_WINDOW, timesteps in which a message can be received: %d\n", local_pid, env_online_metrics_window);
+
+	// The first receptions are found using the cache, that is migrated with the SEs
+	if ( env_online_metrics && ( env_migration > 0 ) && ( env_cache_size == 0 ) ) {
+
+		fprintf(stdout, "LUNES____[%10d]: FATAL ERROR, the online metrics with MIGRATION require the cache (CACHE_SIZE > 0)!!!\n", local_pid);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	//	Runtime configuration:	ping bundling (optional, default is OFF)
+	//
+	if ( getenv("PING_BUNDLING") != NULL )	env_ping_bundling = atoi(getenv("PING_BUNDLING"));
+	fprintf(stdout,"LUNES____[%10d]: PING_BUNDLING, pings directed to the same remote LP are bundled: %d\n", local_pid, env_ping_bundling);
+	//
+	// The records of a bundle are delivered to the LP that was managing their receivers
+	//	when the bundle was sent, therefore the SEs cannot be moved among LPs
+	if ( env_ping_bundling && ( ( ( env_migration > 0 ) && ( env_migration < 4 ) ) || ( env_load == 1 ) ) ) {
+
+		fprintf(stdout, "LUNES____[%10d]: PING_BUNDLING requires both MIGRATION and LOAD to be OFF, the ping bundling is disabled\n", local_pid);
+		env_ping_bundling = 0;
+	}
 }
 
 
@@ -701,15 +1175,48 @@ void	user_environment_handler () {
 */
 void	user_bootstrap_handler () {
 
-	#ifdef TRACE_DISSEMINATION
-	char buffer[1024];
+	int	lp;
 
 
-	// Preparing the simulation trace file
-	sprintf (buffer, "%sSIM_TRACE_%03d.log", TESTNAME, LPID);
+	// The LP that generates a message is encoded in its identifier
+	if ( NLP > ( 1 << MESSAGE_ID_LP_BITS ) ) {
 
-	fp_print_trace = fopen(buffer, "w");
+		fprintf(stdout, "%12.2f FATAL ERROR, at most %d LPs are supported, see constant MESSAGE_ID_LP_BITS in file: lunes_constants.h\n", simclock, 1 << MESSAGE_ID_LP_BITS);
+		fflush(stdout);
+		exit(-1);
+	}
+
+	#ifdef TRACE_DISSEMINATION
+	// Preparing the simulation trace file
+	lunes_trace_open();
 	#endif
+
+	// Preparing the online metrics
+	if ( env_online_metrics )
+		lunes_metrics_init();
+
+	// Allocating an (empty) bundle of pings for each LP
+	if ( env_ping_bundling ) {
+
+		ping_bundles = (PingBundle *) calloc (NLP, sizeof(PingBundle));
+		if ( ping_bundles == NULL ) {
+
+			fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the ping bundles\n", simclock);
+			fflush(stdout);
+			exit(-1);
+		}
+
+		for ( lp = 0; lp < NLP; lp++ ) {
+
+			ping_bundles[lp].buffer = (unsigned char *) malloc (WIRE_HEADER_MAX_SIZE + (MAX_PING_DYNAMIC_RECORDS * WIRE_PING_RECORD_MAX_SIZE));
+			if ( ping_bundles[lp].buffer == NULL ) {
+
+				fprintf(stdout, "%12.2f FATAL ERROR, not enough memory for the ping bundles\n", simclock);
+				fflush(stdout);
+				exit(-1);
+			}
+		}
+	}
 }
 
 
@@ -719,9 +1226,14 @@ void	user_bootstrap_handler () {
 */
 void	user_shutdown_handler () {
 
+	int	lp;
+
 	#ifdef TRACE_DISSEMINATION
-	char	buffer[1024];
-	FILE	*fp_print_messages_trace;
+	char		buffer[1024];
+	FILE		*fp_print_messages_trace;
+	FILE		*fp_print_counters_trace;
+	hash_node_t	*node;
+	unsigned int	h;
 
 	
 	sprintf(buffer, "%stracefile-messages-%d.trace", TESTNAME, LPID);
@@ -731,10 +1243,44 @@ void	user_shutdown_handler () {
 	//	statistics
 	//		total number of pings on the network
 	fprintf(fp_print_messages_trace, "M %010lu\n", get_total_sent_pings ());
+	#ifdef TWO_PHASE_GOSSIP_SUPPORT
+	//		total number of digests, offers and requests on the network (pull phase)
+	//		total number of pulled messages on the network (pull phase)
+	if ( env_dissemination_mode == TWO_PHASE_GOSSIP ) {
+
+		fprintf(fp_print_messages_trace, "D %010lu\n", get_total_sent_digests ());
+		fprintf(fp_print_messages_trace, "U %010lu\n", get_total_sent_pulled ());
+	}
+	#endif
 
 	fclose(fp_print_messages_trace);
 
-	fclose(fp_print_trace);
+	//	statistics
+	//		duplicate and expired receptions of each SE allocated in this LP
+	//		(the counters are migrated with the SEs)
+	sprintf(buffer, "%stracefile-counters-%d.trace", TESTNAME, LPID);
+
+	fp_print_counters_trace = fopen(buffer, "w");
+
+	for ( h = 0; h < stable->count; h++ ) {
+
+		node = stable->list[h];
+		fprintf(fp_print_counters_trace, "C %010u %010u %010u\n", lunes_original_id(node->data->key), node->data->s_state.duplicates, node->data->s_state.ttl_drops);
+	}
+
+	fclose(fp_print_counters_trace);
+
+	lunes_trace_close();
 	#endif
+
+	// Online metrics: the counts of this LP
+	if ( env_online_metrics )
+		lunes_metrics_write();
+
+	if ( ping_bundles ) {
+
+		for ( lp = 0; lp < NLP; lp++ )	free(ping_bundles[lp].buffer);
+		free(ping_bundles);
+	}
 }
 
@@ -30,12 +30,17 @@ void		user_migration_event_handler (hash_node_t *, int, Msg *);
 void		user_model_events_handler (int, int, Msg *, hash_node_t *);
 //	Other handlers
 void		user_control_handler ();
+void		user_end_of_step_handler ();
 void		user_bootstrap_handler ();
 void		user_environment_handler ();
 void		user_shutdown_handler ();
 //	Statistics
 unsigned long	get_total_sent_pings ();
 unsigned long	get_total_received_pings ();
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+unsigned long	get_total_sent_digests ();
+unsigned long	get_total_sent_pulled ();
+#endif
 
 /* ************************************************************************ */
 /* 		S U P P O R T     F U N C T I O N S			    */
@@ -44,7 +49,11 @@ unsigned long	get_total_received_pings ();
 int		add_entity_state_entry (unsigned int, value_element *, int, hash_node_t *);
 gpointer	hash_table_random_key (GHashTable* );
 void		execute_link (double, hash_node_t *, hash_node_t *);
-void		execute_ping (double, hash_node_t *, hash_node_t *, unsigned short, unsigned int, double, unsigned int);
+void		execute_ping (double, hash_node_t *, dir_data_t *, unsigned short, unsigned int, double, unsigned int);
+#ifdef TWO_PHASE_GOSSIP_SUPPORT
+void		execute_digest (double, hash_node_t *, dir_data_t *, char, const unsigned int *, unsigned int);
+void		execute_pulled (double, hash_node_t *, dir_data_t *, unsigned int, double, unsigned int);
+#endif
 
 #endif /* __USER_EVENT_HANDLERS_H */
 
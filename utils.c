@@ -32,20 +32,23 @@
 /* 	         D A T A    S T R U C T U R E S    M A N A G E M E N T       */
 /* ************************************************************************* */
 
-int hash(hash_t *tptr, int x) {
-
-	return  (x % tptr->size);
-}
-
-
 /*
-	Hash table initialization
+	Hash table initialization, all the nodes are allocated here
 */
-void hash_init(hash_t *tptr, int size) {
+void hash_init(enum HASH_TYPE type, hash_t *tptr, int size) {
 
    	tptr->size	= size;
 	tptr->count	= 0;
-   	tptr->bucket	= (hash_node_t **) calloc(tptr->size, sizeof(hash_node_t *));
+   	tptr->node	= (hash_node_t *) calloc(tptr->size, sizeof(hash_node_t));
+   	tptr->list	= (hash_node_t **) calloc(tptr->size, sizeof(hash_node_t *));
+	ASSERT (((tptr->node != NULL) && (tptr->list != NULL)), ("hash_init: calloc error"));
+
+	// Only the global table contains the directory records
+	if(type == GSE) {
+		tptr->dir	= (dir_data_t *) calloc(tptr->size, sizeof(dir_data_t));
+		ASSERT ((tptr->dir != NULL), ("hash_init: calloc error"));
+	}
+	else	tptr->dir	= NULL;
 
    	return;
 }
@@ -56,54 +59,55 @@ void hash_init(hash_t *tptr, int size) {
 */
 hash_node_t *hash_lookup(hash_t *tptr, int key) {
 
-   	int 		h;
-	hash_node_t 	*node;
-
-
-   	h = hash(tptr, key);
-   	for (node=tptr->bucket[h]; node!=NULL; node=node->next) {
-     		if (node->data->key == key)
-      			break;
-   	}
+	if ( (key < 0) || (key >= tptr->size) || (tptr->node[key].dir == NULL) )
+		return(NULL);
 
-   	return(node);
+   	return(&(tptr->node[key]));
 }
 
 
 /*
 	Insertion of a new simulated entity (hash table)
+	-	global table: the directory record of the SE is initialized
+	-	local table: the given directory record is used and the SE state is allocated
 */
-hash_node_t * hash_insert(enum HASH_TYPE type, hash_t *tptr, struct hash_data_t *data, int key, int lp) {
+hash_node_t * hash_insert(enum HASH_TYPE type, hash_t *tptr, struct dir_data_t *dir, int key, int lp) {
 
    	hash_node_t 	*node, *tmp;
-   	int 		h;
 
 
 	if ( (tmp=hash_lookup(tptr, key)) )
 		return(tmp);
-	
-	h		 = hash(tptr, key);
 
-	node		 = (struct hash_node_t *) malloc(sizeof(hash_node_t));
-	ASSERT ((node != NULL), ("hash_insert: malloc error"));
+	// The identifier is out of the boundaries of the table
+	if ( (key < 0) || (key >= tptr->size) )
+		return(NULL);
+	
+	node		 = &(tptr->node[key]);
 
 	//	Inserting the SE in the global hashtable
 	if(type == GSE) {
-		node->data	 = (struct hash_data_t *) malloc(sizeof(hash_data_t));
-		ASSERT ((node->data != NULL), ("hash_insert: malloc error"));
+		node->dir		= &(tptr->dir[key]);
 
-		node->data->key	   	= key;
-		node->data->lp	   	= lp;
+		node->dir->key	   	= key;
+		node->dir->lp	   	= lp;
+		node->data		= NULL;
 
 	}		//	Inserting the SE in the local hashtable
 	else if(type == LSE) {
-		node->data 		= data;
-		node->data->lp	   	= lp;
+		node->dir 		= dir;
+		node->dir->lp	   	= lp;
+
+		node->data	 = (struct hash_data_t *) malloc(sizeof(hash_data_t));
+		ASSERT ((node->data != NULL), ("hash_insert: malloc error"));
+
+		node->data->key		= key;
 	}
 
-   	node->next	= tptr->bucket[h];
-   	tptr->bucket[h]	= node;
-        tptr->count	+= 1;
+	// Appending the node to the list of the table
+	node->position			= tptr->count;
+	tptr->list[tptr->count]		= node;
+        tptr->count			+= 1;
 		
    	return node;
 }
@@ -114,37 +118,24 @@ hash_node_t * hash_insert(enum HASH_TYPE type, hash_t *tptr, struct hash_data_t
 */
 int UNUSED hash_delete(enum HASH_TYPE type, hash_t *tptr, int key) {
 
-	hash_node_t *node, *last;
-   	int h;
-
-
-   	h = hash(tptr, key);
-   	for (node=tptr->bucket[h]; node; node=node->next) {
-     		if (node->data->key == key)
-       			break;
-   	}
+	hash_node_t *node;
 
 
-   	if (node==NULL)
+	if ( (node=hash_lookup(tptr, key)) == NULL )
      		return -1;
 
+	// The last node of the list takes the place of the deleted one
+	tptr->count				-= 1;
+	tptr->list[node->position]		= tptr->list[tptr->count];
+	tptr->list[node->position]->position	= node->position;
+	tptr->list[tptr->count]			= NULL;
 
-   	if (node == tptr->bucket[h])
-     		tptr->bucket[h] = node->next;
-   	else {
-     		for (last=tptr->bucket[h]; last && last->next; last=last->next) {
-       			if (last->next == node)
-         			break;
-     		}
-     		last->next = node->next;
-   	}
-
-	tptr->count	-= 1;
-	
-	if(type == GSE)
+	// The directory record is in the table and it is not freed
+	if(type == LSE)
 		free(node->data);
 
-	free(node);
+	node->dir	= NULL;
+	node->data	= NULL;
 
    	return(1);
 }
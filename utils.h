@@ -37,18 +37,23 @@
 /* ************************************************************************ */
 /* 			            Hash Tables		      	            */
 /* ************************************************************************ */
+// The SE identifiers are dense (from 0 to the total number of SEs - 1), for this
+//	reason the tables of simulated entities are arrays directly indexed by identifier
 enum HASH_TYPE {
 	GSE,							/* Global hash table of simulated entities */
 	LSE,							/* Hash table of locally simulated entities */
 };
 
 typedef struct hash_node_t {
-	struct hash_data_t *data;
-   	struct hash_node_t *next;
+	struct dir_data_t  *dir;				/* Directory record of the SE (both tables), NULL if not in the table */
+	struct hash_data_t *data;				/* State of the SE (only locally simulated entities) */
+	int		   position;				/* Position of the node in the list of the table */
 } hash_node_t;
 
 typedef struct hash_t {
-   	struct hash_node_t **bucket;
+	struct hash_node_t *node;				/* Nodes, indexed by SE identifier */
+	struct hash_node_t **list;				/* Compact list of the nodes in the table, used to scan it */
+	struct dir_data_t  *dir;				/* Directory records, indexed by SE identifier (global table) */
 	int count;
    	int size;
 } hash_t;
@@ -71,13 +76,11 @@ typedef struct se_list {
 /* ************************************************************************ */
 /* 			            Prototypes		      	            */
 /* ************************************************************************ */
-int 			hash(hash_t *, int);
-
-void 			hash_init(hash_t *, int);
+void 			hash_init(enum HASH_TYPE, hash_t *, int);
 
 hash_node_t *		hash_lookup(hash_t *, int);
 
-hash_node_t * 		hash_insert(enum HASH_TYPE, hash_t *, struct hash_data_t *, int, int);
+hash_node_t * 		hash_insert(enum HASH_TYPE, hash_t *, struct dir_data_t *, int, int);
 
 int 			hash_delete(enum HASH_TYPE, hash_t *, int);
 